@@ -0,0 +1,48 @@
+#include "active_blocks.hpp"
+
+namespace partdiff {
+
+  active_blocks::active_blocks(const calculation_options &options, const std::size_t num_rows,
+                               const std::size_t num_cols)
+    : term_accuracy(options.term_accuracy),
+      quiet_threshold(0.25 * options.term_accuracy),
+      num_rows(num_rows),
+      num_cols(num_cols),
+      quiet_sweeps(num_rows * num_cols),
+      skipped(num_rows * num_cols) {}
+
+  void active_blocks::record(const std::size_t row, const std::size_t col, const double residuum) {
+    uint8_t &quiet = this->quiet_sweeps[(row * this->num_cols) + col];
+    if (residuum >= this->quiet_threshold) {
+      quiet = 0;
+    } else if (quiet < quiet_limit) {
+      quiet++;
+    }
+  }
+
+  bool active_blocks::converged(const double residuum) {
+    if (this->full && residuum < this->term_accuracy) {
+      return true;
+    }
+    this->sweeps_since_full = this->full ? 1 : this->sweeps_since_full + 1;
+    // Once the active blocks are below the accuracy, only a full sweep tells whether the quiet ones still are.
+    this->full = (residuum < this->term_accuracy) || (this->sweeps_since_full >= full_sweep_every);
+    if (this->full) {
+      return false;
+    }
+
+    const auto quiet = [this](const std::size_t row, const std::size_t col) {
+      return this->quiet_sweeps[(row * this->num_cols) + col] > 0;
+    };
+    for (std::size_t row = 0; row < this->num_rows; row++) {
+      for (std::size_t col = 0; col < this->num_cols; col++) {
+        this->skipped[(row * this->num_cols) + col] =
+            this->quiet_sweeps[(row * this->num_cols) + col] >= quiet_limit && (row == 0 || quiet(row - 1, col)) &&
+            (row + 1 == this->num_rows || quiet(row + 1, col)) && (col == 0 || quiet(row, col - 1)) &&
+            (col + 1 == this->num_cols || quiet(row, col + 1));
+      }
+    }
+    return false;
+  }
+
+} // namespace partdiff
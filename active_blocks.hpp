@@ -0,0 +1,46 @@
+#pragma once
+
+#include "calculation_options.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace partdiff {
+
+  // Decides which blocks of the grid a sweep skips with --adaptive in accuracy mode. A block whose largest change
+  // stayed below a quarter of the accuracy for a few sweeps in a row is quiet and skipped, since updating it hardly
+  // moves the solution but costs as much memory traffic as any other block. A quiet block next to one that still
+  // changes is not skipped, since its edge will change as well, e.g. in the interior of the grid before the boundary
+  // values have reached it. Every few sweeps, and whenever the visited blocks are below the accuracy, a full sweep
+  // visits all blocks: a quiet block that changes again becomes active, and only a full sweep below the accuracy ends
+  // the run, so it stops on the same criterion as without skipping.
+  // The blocks form a grid of num_rows x num_cols blocks.
+  class active_blocks {
+    public:
+    active_blocks(const calculation_options &options, std::size_t num_rows, std::size_t num_cols);
+    bool enabled() const {
+      return !this->quiet_sweeps.empty();
+    }
+    bool skip(std::size_t row, std::size_t col) const {
+      return !this->full && this->skipped[(row * this->num_cols) + col];
+    }
+    // Records the largest change of a block in the current sweep. Different threads may record different blocks.
+    void record(std::size_t row, std::size_t col, double residuum);
+    // Ends a sweep with the largest change of the blocks it visited, and returns whether the run has converged.
+    // Picks the blocks that the next sweep skips, so it must not run concurrently with skip() or record().
+    bool converged(double residuum);
+
+    private:
+    static constexpr uint8_t quiet_limit = 4;
+    static constexpr uint64_t full_sweep_every = 16;
+    double term_accuracy;
+    double quiet_threshold;
+    std::size_t num_rows, num_cols;
+    // The number of consecutive visits in which a block changed by less than the threshold, up to quiet_limit.
+    std::vector<uint8_t> quiet_sweeps;
+    std::vector<uint8_t> skipped;
+    uint64_t sweeps_since_full = 0;
+    bool full = true;
+  };
+
+} // namespace partdiff
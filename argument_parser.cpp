@@ -24,12 +24,23 @@ namespace partdiff {
     for (std::size_t i = 0; i < num_args; i++) {
       std::print(" [{}]", argument_descriptions[i].name);
     }
+    if (!this->option_descriptions.empty()) {
+      std::print(" [options]");
+    }
     std::println("");
     std::println("");
     for (std::size_t i = 0; i < num_args; i++) {
       const std::string description = this->argument_descriptions[i].description.value_or("<invalid>");
       std::println("{}{}", get_name(this->argument_descriptions[i].name), description);
     }
+    if (!this->option_descriptions.empty()) {
+      const auto get_option_name = [](const std::string &input) { return std::format("  --{:11}", input + "="); };
+      std::println("");
+      std::println("Options:");
+      for (const auto &option : this->option_descriptions) {
+        std::println("{}{}", get_option_name(option.name), option.description.value_or("<invalid>"));
+      }
+    }
     if (epilog.has_value()) {
       std::println("");
       std::println("{}", epilog.value());
@@ -47,9 +58,26 @@ namespace partdiff {
         return false;
       }
     }
+    for (std::size_t i = num_args_expected; i < num_args_given; i++) {
+      if (args[i].starts_with("--") && !parse_option(args[i])) {
+        return false;
+      }
+    }
     return true;
   }
 
+  bool argument_parser::parse_option(const std::string &input) {
+    const std::size_t separator = input.find('=');
+    const std::string name = input.substr(2, separator - 2);
+    const std::string value = (separator == std::string::npos) ? "1" : input.substr(separator + 1);
+    for (const auto &option : this->option_descriptions) {
+      if (option.name == name) {
+        return option.read_from_string(value);
+      }
+    }
+    return false;
+  }
+
   bool argument_parser::parse_arg(const std::size_t index, const std::string &input) {
     return this->argument_descriptions[index].read_from_string(input);
   }
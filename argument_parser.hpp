@@ -1,3 +1,5 @@
+#pragma once
+
 #include "calculation_options.hpp"
 #include <any>
 #include <functional>
@@ -50,6 +52,9 @@ namespace partdiff {
     template <class T>
     void add_arg(std::string name, T &target, std::optional<bounds_t<T>> bounds,
                  std::optional<std::string> description);
+    template <class T>
+    void add_option(std::string name, T &target, std::optional<bounds_t<T>> bounds,
+                    std::optional<std::string> description);
 
     private:
     struct argument_description {
@@ -62,11 +67,32 @@ namespace partdiff {
     const std::optional<std::string> app_name;
     const std::optional<std::string> epilog;
     std::vector<argument_description> argument_descriptions;
+    std::vector<argument_description> option_descriptions;
+
+    bool parse_option(const std::string &input);
+    template <class T>
+    static argument_description describe(std::string name, T &target, std::optional<bounds_t<T>> bounds,
+                                         std::optional<std::string> description);
   };
 
   template <class T>
   void argument_parser::add_arg(std::string name, T &target, std::optional<bounds_t<T>> bounds,
                                 std::optional<std::string> description) {
+    this->argument_descriptions.push_back(describe(name, target, bounds, description));
+  }
+
+  // Options are given as --name=value after the positional arguments and keep the value of their target if they are
+  // missing. --name alone is short for --name=1, which is handy for switches.
+  template <class T>
+  void argument_parser::add_option(std::string name, T &target, std::optional<bounds_t<T>> bounds,
+                                   std::optional<std::string> description) {
+    this->option_descriptions.push_back(describe(name, target, bounds, description));
+  }
+
+  template <class T>
+  argument_parser::argument_description argument_parser::describe(std::string name, T &target,
+                                                                  std::optional<bounds_t<T>> bounds,
+                                                                  std::optional<std::string> description) {
     argument_description arg_desc;
     arg_desc.name = name;
     arg_desc.target = std::reference_wrapper<T>(target);
@@ -88,7 +114,7 @@ namespace partdiff {
       return valid_input;
     };
     arg_desc.description = description;
-    this->argument_descriptions.push_back(arg_desc);
+    return arg_desc;
   }
 
 } // namespace partdiff
@@ -0,0 +1,254 @@
+#include "argument_parser.hpp"
+#include "calculation.hpp"
+#include "calculation_arguments.hpp"
+#include "calculation_options.hpp"
+#include "calculation_results.hpp"
+#include "enums.hpp"
+#include "kernels.hpp"
+#include "option_bounds.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <format>
+#include <memory>
+#include <print>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// partdiff-bench times the sweeps of partdiff in-process: the matrices are set up once, the warmup runs are
+// discarded, and every repetition takes the calculation time of calculate(), i.e. the iteration loop and the start of
+// its threads, without the startup, the initialization of the matrices and the output that a timed partdiff process
+// includes. The achieved bandwidth is put in relation to that of a STREAM-like copy with the same number of threads.
+
+namespace partdiff {
+
+  namespace {
+
+    struct bench_options {
+      calculation_options calculation;
+      uint64_t warmup;
+      uint64_t repetitions;
+      uint64_t stream_mib;
+      std::string format;
+      std::string output_path;
+    };
+
+    constexpr int stream_repetitions = 5;
+
+    bench_options parse_args(const int argc, char const *argv[]) {
+      const std::string app_name = argv[0];
+      const std::vector<std::string> args(argv + 1, argv + argc);
+      argument_parser parser(app_name, std::format("Example: {} 4 2 512 1 100 --output=bench.csv", app_name));
+
+      constexpr int indent_width = 17;
+      const std::string indent = std::format("{:{}s}", "", indent_width);
+
+      uint64_t number;
+      parser.add_arg("num", number, std::make_optional(num_bounds),
+                     std::format("number of threads ({:d})", num_bounds));
+
+      calculation_method method;
+      parser.add_arg("method", method, std::make_optional(method_bounds),
+                     std::format("calculation method ({:d}), except multigrid and CG", method_bounds));
+
+      uint64_t lines;
+      parser.add_arg("lines", lines, std::make_optional(lines_bounds),
+                     std::format("number of interlines ({:d})", lines_bounds));
+
+      perturbation_function func;
+      parser.add_arg("func", func, std::make_optional(func_bounds),
+                     std::format("perturbation function ({:d})", func_bounds));
+
+      uint64_t sweeps;
+      static constexpr bounds_t<uint64_t> sweeps_bounds{1, 200000};
+      parser.add_arg("sweeps", sweeps, std::make_optional(sweeps_bounds),
+                     std::format("iterations per repetition ({:d})", sweeps_bounds));
+
+      simd_kernel kernel = simd_kernel::automatic;
+      parser.add_option("kernel", kernel, std::make_optional(kernel_bounds),
+                        std::format("Jacobi stencil kernel ({:d})", kernel_bounds));
+
+      uint64_t tile_depth = 0;
+      parser.add_option("tile", tile_depth, std::make_optional(tile_depth_bounds),
+                        std::format("Jacobi iterations per pass over the grid ({:d})", tile_depth_bounds));
+
+      bool huge_pages = false;
+      parser.add_option("hugepages", huge_pages, std::optional<bounds_t<bool>>{std::nullopt},
+                        std::string("back the matrices with transparent huge pages (0 .. 1)"));
+
+      storage_precision precision = storage_precision::double_precision;
+      parser.add_option("precision", precision, std::make_optional(precision_bounds),
+                        std::format("storage precision of the matrices ({:d})", precision_bounds));
+
+      uint64_t warmup = 1;
+      static constexpr bounds_t<uint64_t> warmup_bounds{0, 100};
+      parser.add_option("warmup", warmup, std::make_optional(warmup_bounds),
+                        std::format("untimed runs before the repetitions ({:d}, default: 1)", warmup_bounds));
+
+      uint64_t repetitions = 5;
+      static constexpr bounds_t<uint64_t> repetitions_bounds{1, 1000};
+      parser.add_option("repeat", repetitions, std::make_optional(repetitions_bounds),
+                        std::format("timed runs ({:d}, default: 5)", repetitions_bounds));
+
+      uint64_t stream_mib = 256;
+      static constexpr bounds_t<uint64_t> stream_bounds{0, 65536};
+      parser.add_option("stream", stream_mib, std::make_optional(stream_bounds),
+                        std::format("MiB per array of the bandwidth measurement ({:d}, default: 256)\n"
+                                    "{}0 skips it",
+                                    stream_bounds, indent));
+
+      std::string format = "csv";
+      parser.add_option("format", format, std::optional<bounds_t<std::string>>{std::nullopt},
+                        std::string("csv or json (one object per line)"));
+
+      std::string output_path;
+      parser.add_option("output", output_path, std::optional<bounds_t<std::string>>{std::nullopt},
+                        std::string("file to append the result to instead of printing it"));
+
+      if (!parser.parse_args(args) || (format != "csv" && format != "json")) {
+        parser.usage();
+        exit(EXIT_SUCCESS);
+      }
+      if (method == calculation_method::multigrid || method == calculation_method::conjugate_gradient) {
+        std::println("Bench failure! ({:s} doesn't consist of sweeps)", method);
+        exit(EXIT_FAILURE);
+      }
+
+      // Every repetition runs a fixed number of sweeps, without checkpoints and with the optimal omega for SOR.
+      const calculation_options calculation{.number = number,
+                                            .interlines = lines,
+                                            .method = method,
+                                            .pert_func = func,
+                                            .termination = termination_condition::iterations,
+                                            .term_iteration = sweeps,
+                                            .kernel = kernel,
+                                            .tile_depth = tile_depth,
+                                            .huge_pages = huge_pages,
+                                            .precision = precision};
+      return {calculation, warmup, repetitions, stream_mib, format, output_path};
+    }
+
+    // The bandwidth of copying one array into another with num_threads threads, in bytes per second. Like STREAM,
+    // it counts one read and one write per element and reports the best of several repetitions. Every thread first
+    // touches the part of the arrays that it copies, just like the matrices are first touched by their threads.
+    double measure_stream_bandwidth(const uint64_t num_threads, const std::size_t bytes) {
+      const std::size_t n = bytes / sizeof(double);
+      const std::unique_ptr<double[]> a(new double[n]);
+      const std::unique_ptr<double[]> b(new double[n]);
+      const auto chunk = [n, num_threads](const uint64_t t) {
+        return std::pair{(n * t) / num_threads, (n * (t + 1)) / num_threads};
+      };
+      const auto run = [num_threads](const auto &body) {
+        std::vector<std::jthread> threads;
+        for (uint64_t t = 1; t < num_threads; t++) {
+          threads.emplace_back(body, t);
+        }
+        body(0);
+      };
+
+      run([&](const uint64_t t) {
+        const auto [first, last] = chunk(t);
+        std::fill(a.get() + first, a.get() + last, 1.0);
+        std::fill(b.get() + first, b.get() + last, 0.0);
+      });
+
+      double best = 0.0;
+      for (int r = 0; r < stream_repetitions; r++) {
+        const auto start = std::chrono::high_resolution_clock::now();
+        run([&](const uint64_t t) {
+          const auto [first, last] = chunk(t);
+          std::copy(a.get() + first, a.get() + last, b.get() + first);
+        });
+        const auto end = std::chrono::high_resolution_clock::now();
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        best = std::max(2.0 * n * sizeof(double) / seconds, best);
+      }
+
+      // This also keeps the copies from being optimized away.
+      if (n > 0 && b[n - 1] != 1.0) {
+        std::println("Bench failure! (The bandwidth measurement copied wrong values)");
+        exit(EXIT_FAILURE);
+      }
+      return best;
+    }
+
+  } // namespace
+
+} // namespace partdiff
+
+int main(const int argc, char const *argv[]) {
+  using namespace partdiff;
+
+  const bench_options bench = parse_args(argc, argv);
+  const calculation_options &options = bench.calculation;
+  calculation_arguments arguments(options);
+
+  for (uint64_t w = 0; w < bench.warmup; w++) {
+    calculate(arguments, options);
+  }
+  std::vector<double> seconds_per_sweep;
+  for (uint64_t r = 0; r < bench.repetitions; r++) {
+    const calculation_results results = calculate(arguments, options);
+    const double seconds = std::chrono::duration<double>(results.end_time - results.start_time).count();
+    seconds_per_sweep.push_back(seconds / options.term_iteration);
+  }
+  const double best = *std::min_element(seconds_per_sweep.begin(), seconds_per_sweep.end());
+  double mean = 0.0;
+  for (const double s : seconds_per_sweep) {
+    mean += s / seconds_per_sweep.size();
+  }
+
+  // Every sweep has to read and write every interior point at least once, and red-black does so once per colour.
+  // The neighbours come from the cache, so this is the traffic that a sweep at the roofline would cause. Temporal
+  // tiling saves some of it, so tiled runs may exceed the measured bandwidth.
+  const double num_points = (double)(arguments.N - 1) * (double)(arguments.N - 1);
+  const int passes = (options.method == calculation_method::red_black) ? 2 : 1;
+  const double bytes_per_sweep = passes * 2.0 * arguments.element_size * num_points;
+  const double bandwidth = bytes_per_sweep / best;
+  const double stream_bandwidth =
+      (bench.stream_mib > 0) ? measure_stream_bandwidth(arguments.num_threads, bench.stream_mib << 20) : 0.0;
+  const double efficiency = (stream_bandwidth > 0.0) ? bandwidth / stream_bandwidth : 0.0;
+  const simd_kernel kernel =
+      (options.method == calculation_method::jacobi) ? resolve_simd_kernel(options.kernel) : simd_kernel::scalar;
+
+  std::FILE *out = stdout;
+  bool header = true;
+  if (!bench.output_path.empty()) {
+    out = std::fopen(bench.output_path.c_str(), "a");
+    if (!out) {
+      std::println("Bench failure! (Could not open {})", bench.output_path);
+      return EXIT_FAILURE;
+    }
+    std::fseek(out, 0, SEEK_END);
+    header = (std::ftell(out) == 0);
+  }
+
+  if (bench.format == "csv") {
+    if (header) {
+      std::println(out, "method,method_name,lines,func,threads,precision,kernel,tile,sweeps,repetitions,"
+                        "seconds_per_sweep,mean_seconds_per_sweep,points_per_second,bytes_per_sweep,"
+                        "gb_per_second,stream_gb_per_second,efficiency");
+    }
+    std::println(out, "{:d},\"{:s}\",{},{:d},{},{:d},\"{:s}\",{},{},{},{:e},{:e},{:e},{:e},{:.3f},{:.3f},{:.4f}",
+                 options.method, options.method, options.interlines, options.pert_func, arguments.num_threads,
+                 options.precision, kernel, options.tile_depth, options.term_iteration, bench.repetitions, best, mean,
+                 num_points / best, bytes_per_sweep, bandwidth / 1e9, stream_bandwidth / 1e9, efficiency);
+  } else {
+    std::println(out,
+                 "{{\"method\": {:d}, \"method_name\": \"{:s}\", \"lines\": {}, \"func\": {:d}, \"threads\": {}, "
+                 "\"precision\": {:d}, \"kernel\": \"{:s}\", \"tile\": {}, \"sweeps\": {}, \"repetitions\": {}, "
+                 "\"seconds_per_sweep\": {:e}, \"mean_seconds_per_sweep\": {:e}, \"points_per_second\": {:e}, "
+                 "\"bytes_per_sweep\": {:e}, \"gb_per_second\": {:.3f}, \"stream_gb_per_second\": {:.3f}, "
+                 "\"efficiency\": {:.4f}}}",
+                 options.method, options.method, options.interlines, options.pert_func, arguments.num_threads,
+                 options.precision, kernel, options.tile_depth, options.term_iteration, bench.repetitions, best, mean,
+                 num_points / best, bytes_per_sweep, bandwidth / 1e9, stream_bandwidth / 1e9, efficiency);
+  }
+
+  if (out != stdout) {
+    std::fclose(out);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,25 @@
+#!/usr/bin/env bash
+
+# Collects bench.csv for plot_benchmark.plt. partdiff-bench times the sweeps in-process, so unlike timed partdiff
+# processes the numbers contain neither the startup nor the initialization of the matrices.
+
+set -e
+
+cd ../../
+make partdiff-bench
+
+out="benchmark/roofline/bench.csv"
+rm -f "$out"
+
+date
+
+for m in 1 2 3 6 ; do
+  for l in 64 128 256 512 1024 ; do
+    for n in 1 2 4 8 ; do
+      echo 'm = '"$m"'; l = '"$l"'; n = '"$n"
+      ./partdiff-bench "$n" "$m" "$l" 2 20 --output="$out"
+    done
+  done
+done
+
+date
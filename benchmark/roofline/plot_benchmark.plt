@@ -0,0 +1,39 @@
+#!/usr/bin/env gnuplot
+
+set term pdf;
+set termopt enhanced
+
+in_file="bench.csv"
+set datafile separator ","
+set key autotitle columnhead
+set key left top
+
+# Columns of bench.csv, see partdiff-bench
+method = 1
+lines = 3
+threads = 5
+gb_per_second = 15
+stream_gb_per_second = 16
+efficiency = 17
+
+methods = "1 2 3 6"
+names = "Gauß-Seidel Jacobi Red-Black SOR"
+colors = "#FF0000 #0000FF #00AA00 #AA00AA"
+
+set xlabel "Threads"
+set ylabel "Bandwidth / GB/s"
+set logscale x 2
+set output "Bandwidth.pdf"
+plot for [i=1:words(methods)] in_file using (column(method) == word(methods, i) + 0 && column(lines) == 1024 ? \
+       column(threads) : NaN):gb_per_second with linespoints pointtype 7 pointsize 0.3 \
+       lt rgb word(colors, i) title word(names, i), \
+     in_file using (column(lines) == 1024 && column(method) == 2 ? column(threads) : NaN):stream_gb_per_second \
+       with lines dashtype 2 lt rgb "#000000" title "STREAM copy";
+
+set xlabel "Interlines"
+set ylabel "Fraction of the STREAM bandwidth"
+set yrange [0 : *]
+set output "Efficiency.pdf"
+plot for [i=1:words(methods)] in_file using (column(method) == word(methods, i) + 0 && column(threads) == 1 ? \
+       column(lines) : NaN):efficiency with linespoints pointtype 7 pointsize 0.3 \
+       lt rgb word(colors, i) title word(names, i);
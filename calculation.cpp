@@ -0,0 +1,514 @@
+#include "calculation.hpp"
+#include "active_blocks.hpp"
+#include "checkpoint.hpp"
+#include "conjugate_gradient.hpp"
+#include "convergence_check.hpp"
+#include "enums.hpp"
+#include "kernels.hpp"
+#include "multigrid.hpp"
+#include "nested_iteration.hpp"
+#include "perf_counters.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <barrier>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace partdiff {
+
+  namespace {
+
+    // One cache line per thread, so that the threads don't fight over the line holding their neighbour's residuum.
+    struct alignas(64) padded_residuum {
+      double value = 0.0;
+    };
+
+    // The time that a thread spent on the current sweep, for the trace.
+    struct alignas(64) padded_seconds {
+      double value = 0.0;
+    };
+
+    // The size of the blocks that --adaptive may skip. The rows of a block are long enough to keep the hardware
+    // prefetchers busy.
+    constexpr int adaptive_block_rows = 64;
+    constexpr int adaptive_block_cols = 256;
+
+    // Number of column blocks the thread above has finished in the current Gauß-Seidel sweep.
+    struct alignas(64) padded_progress {
+      std::atomic<int> value = 0;
+    };
+
+    template <typename T>
+    calculation_results calculate(basic_tensor<T> &matrices, calculation_arguments &arguments,
+                                  const calculation_options &options) {
+
+      const auto now = std::chrono::high_resolution_clock::now;
+
+      const auto start_time = now();
+
+      uint64_t stat_iteration = arguments.initial_iteration;
+      double stat_accuracy = arguments.initial_accuracy;
+
+      const int N = arguments.N;
+
+      // The iterations left until term_iteration. In accuracy mode it caps the run, e.g. with float storage, whose
+      // rounding may keep the residuum above the accuracy forever.
+      int term_iteration = static_cast<int>(options.term_iteration) - static_cast<int>(stat_iteration);
+
+      int m2 = arguments.initial_m;
+      int m1 = (options.method == calculation_method::jacobi) ? 1 - m2 : m2;
+
+      // The interior rows are split into one band per thread. Jacobi only reads from m2 and only writes to m1, so the
+      // bands are independent. Gauß-Seidel needs the already updated values of the row above, so the bands are swept as
+      // a wavefront: every band is split into column blocks, and a thread only starts a block once the thread above has
+      // finished the same block. This yields exactly the serial update order. SOR has the same dependencies. Red-black
+      // Gauß-Seidel first updates all red and then all black points of the checkerboard, and each half-sweep is as
+      // independent as a Jacobi sweep.
+      const int num_rows = N - 1;
+      const int num_cols = N - 1;
+      const int num_threads = arguments.num_threads;
+      const bool wavefront = ((options.method == calculation_method::gauss_seidel ||
+                               options.method == calculation_method::sor) &&
+                              num_threads > 1);
+
+      // With --adaptive, every thread splits its band into blocks of about adaptive_block_rows x adaptive_block_cols,
+      // whose columns are those of the wavefront blocks if there is a wavefront. Splitting a Gauß-Seidel sweep into
+      // blocks keeps the serial update order, as the wavefront shows, so only the skipped blocks change the result.
+      // A block that Jacobi skips keeps the values of two sweeps ago in the matrix it would have written, which differ
+      // from the current ones by less than the threshold of a quiet block. Red-black Gauß-Seidel has no blocks to skip.
+      const bool adaptive = (options.adaptive && options.termination == termination_condition::accuracy &&
+                             options.method != calculation_method::red_black);
+      const int band_rows = (num_rows + num_threads - 1) / num_threads;
+      const int num_blocks = wavefront ? std::min(num_cols, 8 * num_threads)
+                                       : (adaptive ? std::max(1, num_cols / adaptive_block_cols) : 1);
+      const int num_chunks = adaptive ? std::max(1, band_rows / adaptive_block_rows) : 1;
+      active_blocks blocks(options, adaptive ? num_threads * num_chunks : 0, num_blocks);
+
+      // With temporal tiling, Jacobi performs up to tile_depth iterations in a single pass over the grid: in step s,
+      // iteration (level) k of the pass updates row s - k + 1, so every level trails the one before it by one row
+      // and only a few rows per level have to stay in the cache. The levels alternate between the two matrices,
+      // which is safe because a row of level k - 2 is only overwritten by level k after level k - 1 has consumed it.
+      // With several threads, the levels are dealt out round-robin and each level waits for the progress of the one
+      // before it. Since the accuracy is only known after a whole iteration, tiling is restricted to the iteration
+      // mode.
+      const bool tiled = (options.method == calculation_method::jacobi &&
+                          options.termination == termination_condition::iterations && options.tile_depth > 1);
+
+      // With --fused, Jacobi performs two iterations per pass, in both modes, and without the second matrix: the first
+      // iteration writes its rows into a ring of three rows, and the second one follows a row behind and writes its
+      // rows back into the matrix, whose rows the first iteration has consumed by then. So a pass reads and writes the
+      // matrix once for two iterations. The row kernels are the ones of the sweeps, so the result is identical. A pass
+      // can only end on its second iteration, so a single sweep is done instead whenever the first one has to compute
+      // the residuum, i.e. in accuracy mode when it is checked and in iteration mode when it is the last one.
+      const bool fused = (options.method == calculation_method::jacobi && options.fused && !tiled && !adaptive);
+      const int tile_depth = tiled ? static_cast<int>(options.tile_depth) : (fused ? 2 : 1);
+
+      // Without a user-supplied omega, SOR uses the optimal one for the Laplacian on the unit square.
+      const double omega =
+          (options.omega > 0.0) ? options.omega : 2.0 / (1.0 + std::sin(std::numbers::pi * arguments.h));
+
+      // The kernels are picked once per run. Only the last sweep needs the residuum, and in accuracy mode the sweeps
+      // that check for convergence.
+      const simd_kernel simd = resolve_simd_kernel(options.kernel);
+      const std::array<sweep_kernel<T>, 2> kernels = {
+          select_kernel<T>(options.method, options.pert_func, false, 0, simd, options.precision),
+          select_kernel<T>(options.method, options.pert_func, false, 1, simd, options.precision),
+      };
+      const std::array<sweep_kernel<T>, 2> residuum_kernels = {
+          select_kernel<T>(options.method, options.pert_func, true, 0, simd, options.precision),
+          select_kernel<T>(options.method, options.pert_func, true, 1, simd, options.precision),
+      };
+      const std::array<jacobi_row_kernel_t<T>, 2> row_kernels = {
+          select_jacobi_row<T>(options.pert_func, false, simd, options.precision),
+          select_jacobi_row<T>(options.pert_func, true, simd, options.precision),
+      };
+
+      std::optional<checkpoint_writer> checkpoint;
+      uint64_t next_checkpoint = stat_iteration + options.checkpoint_every;
+      if (!options.checkpoint_path.empty() && options.checkpoint_every > 0) {
+        checkpoint.emplace(options.checkpoint_path, options, arguments);
+      }
+
+      convergence_check check = (arguments.initial_check.interval > 0)
+                                    ? convergence_check(options, arguments.initial_check)
+                                    : convergence_check(options, stat_iteration);
+      const auto pass_depth = [&]() {
+        if (fused && options.termination == termination_condition::accuracy && check.due(stat_iteration)) {
+          return 1;
+        }
+        return std::min(tile_depth, term_iteration);
+      };
+      int depth = pass_depth();
+      // Whether the last sweep of the next pass needs the residuum.
+      const auto residuum_due = [&]() {
+        if (blocks.enabled()) {
+          return true;
+        }
+        return (options.termination == termination_condition::accuracy && check.due(stat_iteration + depth - 1)) ||
+               term_iteration == depth;
+      };
+
+      // Traced sweeps also compute the residuum, so that the trace shows the convergence.
+      trace_buffer trace(options);
+      std::vector<padded_seconds> thread_seconds(trace.enabled() ? num_threads : 0);
+      std::vector<double> sweep_seconds(thread_seconds.size());
+      const auto clock_out = [&](const int thread_id, const calculation_results::time_point sweep_begin) {
+        thread_seconds[thread_id].value = std::chrono::duration<double>(now() - sweep_begin).count();
+      };
+
+      std::vector<perf_sample> perf_samples(options.perf ? num_threads : 0);
+      std::string perf_error;
+
+      std::vector<padded_residuum> residua(num_threads);
+      std::vector<padded_progress> progress(std::max(num_threads, tile_depth));
+      bool done = (term_iteration <= 0);
+      bool snapshot_due = false;
+      // Reported sweeps compute the residuum as well. Only the sweeps that are due check it, though, so that tracing or
+      // reporting doesn't change when the run converges.
+      solve_control *const control = arguments.control;
+      const auto report_due = [&]() { return control && control->due(stat_iteration, depth); };
+      bool traced = trace.due(stat_iteration, depth);
+      bool reported = report_due();
+      bool checked = residuum_due();
+      bool compute_residuum = checked || traced || reported;
+      auto sweep_begin = now();
+
+      // Runs on exactly one thread after all threads have finished a sweep, so it may touch the shared state freely.
+      // Everything written here is visible to all threads once they return from the barrier.
+      const auto finish_iteration = [&]() noexcept {
+        double maxresiduum = 0.0;
+        for (const auto &r : residua) {
+          maxresiduum = std::max(r.value, maxresiduum);
+        }
+
+        stat_iteration += depth;
+        if (checked || options.termination == termination_condition::iterations) {
+          stat_accuracy = maxresiduum;
+        }
+
+        const bool residuum_computed = tiled ? (term_iteration == depth) : compute_residuum;
+        const double reported_residuum = residuum_computed ? maxresiduum : std::numeric_limits<double>::quiet_NaN();
+        if (traced) {
+          for (int t = 0; t < num_threads; t++) {
+            sweep_seconds[t] = thread_seconds[t].value;
+          }
+          trace.record(stat_iteration, std::chrono::duration<double>(now() - sweep_begin).count(), reported_residuum,
+                       sweep_seconds);
+        }
+        if (reported) {
+          control->report(stat_iteration, reported_residuum);
+        }
+
+        if (depth % 2 == 1) {
+          const int temp = m1;
+          m1 = m2;
+          m2 = temp;
+        }
+
+        term_iteration -= depth;
+        if (options.termination == termination_condition::accuracy && blocks.enabled()) {
+          if (blocks.converged(maxresiduum)) {
+            term_iteration = 0;
+          }
+        } else if (options.termination == termination_condition::accuracy) {
+          if (checked && check.converged(stat_iteration, maxresiduum)) {
+            term_iteration = 0;
+          }
+        }
+        if (control && control->cancelled()) {
+          term_iteration = 0;
+        }
+        // A checkpoint that could not be written ends the run, and finish() reports it below.
+        if (checkpoint && checkpoint->failed()) {
+          term_iteration = 0;
+        }
+
+        done = (term_iteration <= 0);
+        depth = pass_depth();
+        traced = trace.due(stat_iteration, depth);
+        reported = report_due();
+        checked = residuum_due();
+        compute_residuum = checked || traced || reported;
+
+        // The threads copy their bands into the snapshot before the next pass.
+        snapshot_due = checkpoint && !done && stat_iteration >= next_checkpoint;
+        if (snapshot_due) {
+          checkpoint->begin(m2, stat_iteration, stat_accuracy, check.saved(), num_threads);
+          next_checkpoint = stat_iteration + options.checkpoint_every;
+        }
+
+        for (auto &p : progress) {
+          p.value.store(0, std::memory_order_relaxed);
+        }
+
+        if (traced) {
+          sweep_begin = now();
+        }
+      };
+
+      std::barrier sync(num_threads, finish_iteration);
+      std::barrier<> half_sync(num_threads);
+
+      const auto tiled_pass = [&](const int thread_id) {
+        // Only the last iteration of the run needs the residuum.
+        const bool last_pass = (term_iteration == depth);
+        double maxresiduum = 0.0;
+
+        for (int step = 1; step < num_rows + depth; step++) {
+          for (int level = thread_id + 1; level <= depth; level += num_threads) {
+            const int i = step - level + 1;
+            if (i < 1 || i > num_rows) {
+              continue;
+            }
+
+            if (level > 1) {
+              auto &previous = progress[level - 2].value;
+              const int needed = std::min(i + 1, num_rows);
+              for (int p = previous.load(std::memory_order_acquire); p < needed;
+                   p = previous.load(std::memory_order_acquire)) {
+                previous.wait(p, std::memory_order_acquire);
+              }
+            }
+
+            const int target = (level % 2 == 1) ? m1 : m2;
+            const int source = (level % 2 == 1) ? m2 : m1;
+            const auto &kernel = (last_pass && level == depth) ? residuum_kernels : kernels;
+            const sweep_range range = {i, i + 1, 1, N};
+            const double row_maxresiduum = kernel[0](matrices, target, source, range, arguments.perturbation, omega);
+            maxresiduum = std::max(row_maxresiduum, maxresiduum);
+
+            progress[level - 1].value.store(i, std::memory_order_release);
+            progress[level - 1].value.notify_one();
+          }
+        }
+
+        residua[thread_id].value = maxresiduum;
+      };
+
+      // The rows of the first iteration that a fused pass needs: three rows in the ring, the rows just outside the
+      // band, which the neighbouring threads compute as well, and a copy of the rows of the previous iteration just
+      // outside the band, which the neighbouring threads overwrite while this one still needs them.
+      struct fused_rows {
+        std::vector<T> ring, halo_above, halo_below, saved_above, saved_below;
+        explicit fused_rows(const int N)
+          : ring(3 * (N + 1)),
+            halo_above(N + 1),
+            halo_below(N + 1),
+            saved_above(N + 1),
+            saved_below(N + 1) {}
+      };
+
+      const auto fused_pass = [&](const int thread_id, fused_rows &rows) {
+        const auto [i_begin, i_end] = arguments.row_band(thread_id);
+        const auto &row_kernel = row_kernels[compute_residuum];
+        const perturbation_source &perturbation = arguments.perturbation;
+
+        // The first iteration of a row into out, whose boundary columns are the same as in the matrix.
+        const auto first_iteration = [&](T *out, const T *above, const T *centre, const T *below, const int i) {
+          out[0] = centre[0];
+          out[N] = centre[N];
+          row_kernels[0](out, above, centre, below, i, 1, N, perturbation);
+        };
+
+        const int above = i_begin - 1;
+        const int below = i_end;
+        std::copy_n(matrices.row(m2, above), N + 1, rows.saved_above.begin());
+        std::copy_n(matrices.row(m2, below), N + 1, rows.saved_below.begin());
+        if (above == 0) {
+          rows.halo_above = rows.saved_above;
+        } else {
+          first_iteration(rows.halo_above.data(), matrices.row(m2, above - 1), matrices.row(m2, above),
+                          matrices.row(m2, above + 1), above);
+        }
+        if (below == N) {
+          rows.halo_below = rows.saved_below;
+        } else {
+          first_iteration(rows.halo_below.data(), matrices.row(m2, below - 1), matrices.row(m2, below),
+                          matrices.row(m2, below + 1), below);
+        }
+        half_sync.arrive_and_wait();
+
+        const auto current_row = [&](const int i) -> const T * {
+          return (i == above) ? rows.saved_above.data() : (i == below) ? rows.saved_below.data() : matrices.row(m2, i);
+        };
+        const auto intermediate_row = [&](const int i) -> T * {
+          return (i == above) ? rows.halo_above.data() : (i == below) ? rows.halo_below.data()
+                                                                        : &rows.ring[(i % 3) * (N + 1)];
+        };
+
+        double maxresiduum = 0.0;
+        for (int i = i_begin; i <= i_end; i++) {
+          if (i < i_end) {
+            first_iteration(intermediate_row(i), current_row(i - 1), current_row(i), current_row(i + 1), i);
+          }
+          if (i > i_begin) {
+            const double row_maxresiduum = row_kernel(matrices.row(m2, i - 1), intermediate_row(i - 2),
+                                                      intermediate_row(i - 1), intermediate_row(i), i - 1, 1, N,
+                                                      perturbation);
+            maxresiduum = std::max(row_maxresiduum, maxresiduum);
+          }
+        }
+        residua[thread_id].value = maxresiduum;
+      };
+
+      const auto worker = [&](const int thread_id) {
+        const auto [i_begin, i_end] = arguments.row_band(thread_id);
+
+        std::optional<perf_counters> counters;
+        if (options.perf) {
+          counters.emplace();
+          counters->start();
+        }
+
+        std::optional<fused_rows> rows;
+        if (fused) {
+          rows.emplace(N);
+        }
+
+        while (!done) {
+          // A tiled pass writes to the rows of every band, so the next pass waits until the snapshot is complete.
+          if (snapshot_due) {
+            const int first = (thread_id == 0) ? 0 : i_begin;
+            const int last = (thread_id == num_threads - 1) ? N + 1 : i_end;
+            checkpoint->save_rows(matrices, first, last);
+            half_sync.arrive_and_wait();
+          }
+
+          const auto thread_begin = traced ? now() : calculation_results::time_point{};
+
+          if (tiled) {
+            tiled_pass(thread_id);
+            if (traced) {
+              clock_out(thread_id, thread_begin);
+            }
+            sync.arrive_and_wait();
+            continue;
+          }
+
+          if (fused && depth == 2) {
+            fused_pass(thread_id, *rows);
+            if (traced) {
+              clock_out(thread_id, thread_begin);
+            }
+            sync.arrive_and_wait();
+            continue;
+          }
+
+          const auto &kernel = compute_residuum ? residuum_kernels : kernels;
+          double maxresiduum = 0.0;
+
+          if (options.method == calculation_method::red_black) {
+            const sweep_range range = {i_begin, i_end, 1, N};
+            const double red_maxresiduum = kernel[0](matrices, m1, m2, range, arguments.perturbation, omega);
+            half_sync.arrive_and_wait();
+            const double black_maxresiduum = kernel[1](matrices, m1, m2, range, arguments.perturbation, omega);
+            residua[thread_id].value = std::max(red_maxresiduum, black_maxresiduum);
+            if (traced) {
+              clock_out(thread_id, thread_begin);
+            }
+            sync.arrive_and_wait();
+            continue;
+          }
+
+          for (int block = 0; block < num_blocks; block++) {
+            const int j_begin = 1 + (num_cols * block) / num_blocks;
+            const int j_end = 1 + (num_cols * (block + 1)) / num_blocks;
+
+            if (wavefront && thread_id > 0) {
+              auto &above = progress[thread_id - 1].value;
+              for (int p = above.load(std::memory_order_acquire); p <= block;
+                   p = above.load(std::memory_order_acquire)) {
+                above.wait(p, std::memory_order_acquire);
+              }
+            }
+
+            for (int chunk = 0; chunk < num_chunks; chunk++) {
+              const int block_row = (thread_id * num_chunks) + chunk;
+              if (blocks.skip(block_row, block)) {
+                continue;
+              }
+              const int chunk_begin = i_begin + ((i_end - i_begin) * chunk) / num_chunks;
+              const int chunk_end = i_begin + ((i_end - i_begin) * (chunk + 1)) / num_chunks;
+              const sweep_range range = {chunk_begin, chunk_end, j_begin, j_end};
+              const double block_maxresiduum = kernel[0](matrices, m1, m2, range, arguments.perturbation, omega);
+              if (blocks.enabled()) {
+                blocks.record(block_row, block, block_maxresiduum);
+              }
+              maxresiduum = std::max(block_maxresiduum, maxresiduum);
+            }
+
+            if (wavefront) {
+              progress[thread_id].value.store(block + 1, std::memory_order_release);
+              progress[thread_id].value.notify_one();
+            }
+          }
+
+          residua[thread_id].value = maxresiduum;
+          if (traced) {
+            clock_out(thread_id, thread_begin);
+          }
+          sync.arrive_and_wait();
+        }
+
+        if (counters) {
+          perf_samples[thread_id] = counters->stop();
+          if (thread_id == 0) {
+            perf_error = counters->error().value_or("");
+          }
+        }
+      };
+
+      {
+        std::vector<std::jthread> threads;
+        threads.reserve(num_threads - 1);
+        for (int t = 1; t < num_threads; t++) {
+          threads.emplace_back(worker, t);
+        }
+        worker(0);
+      }
+
+      const auto end_time = now();
+
+      if (checkpoint) {
+        checkpoint->finish();
+      }
+      if (trace.enabled()) {
+        trace.write(options.trace_path);
+      }
+
+      calculation_results results = {m2, stat_iteration, stat_accuracy, start_time, end_time, perf_samples, perf_error};
+      return results;
+    }
+
+  } // namespace
+
+  calculation_results calculate(calculation_arguments &arguments, const calculation_options &options) {
+    if (warm_start_enabled(arguments, options)) {
+      // The time of the calculation includes that of the coarser grids, the iterations are those on this grid.
+      const auto start_time = std::chrono::high_resolution_clock::now();
+      warm_start(arguments, options);
+      calculation_options fine_options = options;
+      fine_options.nested = false;
+      calculation_results results = calculate(arguments, fine_options);
+      results.start_time = start_time;
+      return results;
+    }
+    if (options.method == calculation_method::multigrid) {
+      return calculate_multigrid(arguments, options);
+    }
+    if (options.method == calculation_method::conjugate_gradient) {
+      return calculate_conjugate_gradient(arguments, options);
+    }
+    if (options.precision == storage_precision::double_precision) {
+      return calculate(arguments.matrices, arguments, options);
+    }
+    return calculate(arguments.matrices_float, arguments, options);
+  }
+
+} // namespace partdiff
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "calculation_arguments.hpp"
+#include "calculation_options.hpp"
+#include "calculation_results.hpp"
+
+namespace partdiff {
+
+  calculation_results calculate(calculation_arguments &arguments, const calculation_options &options);
+
+} // namespace partdiff
@@ -1,37 +1,152 @@
 #include "calculation_arguments.hpp"
 #include "calculation_options.hpp"
+#include "checkpoint.hpp"
 #include "enums.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace partdiff {
 
-  calculation_arguments::calculation_arguments(const calculation_options &options) : pert_func(options.pert_func) {
+  calculation_arguments::calculation_arguments(const calculation_options &options, const int rank, const int num_ranks)
+    : calculation_arguments(options, rank, num_ranks, nullptr) {}
+
+  calculation_arguments::calculation_arguments(const calculation_options &options, tensor_pool &pool)
+    : calculation_arguments(options, 0, 1, &pool) {}
+
+  calculation_arguments::calculation_arguments(const calculation_options &options, const int rank, const int num_ranks,
+                                               tensor_pool *pool)
+    : pert_func(options.pert_func),
+      precision(options.precision),
+      huge_pages(options.huge_pages) {
+    const auto setup_start = std::chrono::steady_clock::now();
     this->N = (options.interlines * 8) + 9 - 1;
+    this->first_row = ((N - 1) * rank) / num_ranks;
+    this->last_row = 1 + ((N - 1) * (rank + 1)) / num_ranks;
     this->num_matrices = (options.method == calculation_method::jacobi) ? 2 : 1;
+    this->num_threads = std::min<uint64_t>(options.number, last_row - first_row - 1);
     this->h = 1.0 / this->N;
-    this->matrices = tensor(num_matrices, N + 1, N + 1);
-    this->init_matrices();
+    this->initial_m = (options.method == calculation_method::jacobi) ? 1 : 0;
+    this->element_size = (this->precision == storage_precision::double_precision) ? sizeof(double) : sizeof(float);
+    if (!options.resume_path.empty()) {
+      load_checkpoint(options.resume_path, *this);
+    } else if (this->precision == storage_precision::double_precision) {
+      std::optional<tensor> reused = pool ? pool->acquire<double>(this->shape()) : std::nullopt;
+      this->matrices = reused ? std::move(*reused)
+                              : tensor(num_matrices, last_row - first_row + 1, N + 1, options.huge_pages, first_row);
+      this->init_matrices(this->matrices, !reused);
+    } else {
+      std::optional<basic_tensor<float>> reused = pool ? pool->acquire<float>(this->shape()) : std::nullopt;
+      this->matrices_float =
+          reused ? std::move(*reused)
+                 : basic_tensor<float>(num_matrices, last_row - first_row + 1, N + 1, options.huge_pages, first_row);
+      this->init_matrices(this->matrices_float, !reused);
+    }
+    this->perturbation = perturbation_source(pert_func, N, h);
+    this->setup_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - setup_start).count();
   }
 
-  void calculation_arguments::init_matrices() {
-    for (uint64_t g = 0; g < this->num_matrices; g++) {
-      for (uint64_t i = 0; i <= N; i++) {
-        for (uint64_t j = 0; j <= N; j++) {
-          this->matrices[g, i, j] = 0.0;
-        }
+  tensor_pool::shape calculation_arguments::shape() const {
+    return {this->num_matrices, this->last_row - this->first_row + 1, this->N + 1, this->first_row, this->huge_pages};
+  }
+
+  void calculation_arguments::release_matrices(tensor_pool &pool) {
+    if (this->precision == storage_precision::double_precision) {
+      pool.release(this->shape(), std::move(this->matrices));
+    } else {
+      pool.release(this->shape(), std::move(this->matrices_float));
+    }
+  }
+
+  double calculation_arguments::value(uint64_t matrix, uint64_t row, uint64_t col) const {
+    if (this->precision == storage_precision::double_precision) {
+      return this->matrices[matrix, row, col];
+    }
+    return this->matrices_float[matrix, row, col];
+  }
+
+  matrix_sample calculation_arguments::sample(const int m, const uint64_t interlines) const {
+    matrix_sample values{};
+    for (uint64_t y = 0; y < 9; y++) {
+      const uint64_t row = y * (interlines + 1);
+      const bool own_row = (row > this->first_row && row < this->last_row) || (row == 0 && this->first_row == 0) ||
+                           (row == N && this->last_row == N);
+      if (!own_row) {
+        continue;
+      }
+      for (uint64_t x = 0; x < 9; x++) {
+        values[y][x] = this->value(m, row, x * (interlines + 1));
       }
     }
-    if (this->pert_func == perturbation_function::f0) {
+    return values;
+  }
+
+  std::pair<int, int> calculation_arguments::row_band(int thread_id) const {
+    const uint64_t num_rows = last_row - first_row - 1;
+    const int first = first_row + 1 + (num_rows * thread_id) / num_threads;
+    const int last = first_row + 1 + (num_rows * (thread_id + 1)) / num_threads;
+    return {first, last};
+  }
+
+  template <typename T>
+  void calculation_arguments::init_matrices(basic_tensor<T> &matrices, const bool zeroed) {
+    const auto init_band = [this, &matrices, zeroed](const int thread_id) {
+      auto [first, last] = this->row_band(thread_id);
+      if (thread_id == 0) {
+        first = this->first_row;
+      }
+      if (thread_id == static_cast<int>(this->num_threads) - 1) {
+        last = this->last_row + 1;
+      }
       for (uint64_t g = 0; g < this->num_matrices; g++) {
-        for (uint64_t i = 0; i <= N; i++) {
-          this->matrices[g, i, 0] = 1.0 - (h * i);
-          this->matrices[g, i, N] = h * i;
-          this->matrices[g, 0, i] = 1.0 - (h * i);
-          this->matrices[g, N, i] = h * i;
+        T *const begin = matrices.row(g, first);
+        T *const end = matrices.row(g, last);
+        if (zeroed) {
+          // A fresh tensor already reads as zeros, so one store per page is enough to fault the pages in from this
+          // thread. The first store is at begin and the others are on the page boundaries, so that no thread stores
+          // into the rows of another.
+          constexpr std::size_t page_elements = 4096 / sizeof(T);
+          const std::size_t offset = reinterpret_cast<std::uintptr_t>(begin) / sizeof(T) % page_elements;
+          *begin = T(0.0);
+          for (T *page = begin + (page_elements - offset); page < end; page += page_elements) {
+            *page = T(0.0);
+          }
+        } else {
+          std::fill(begin, end, T(0.0));
+        }
+        if (this->pert_func != perturbation_function::f0) {
+          continue;
+        }
+        // The boundary of the band: the outer columns, and the top and bottom row if the band holds them. The
+        // corners that belong to both are 0.
+        for (int i = first; i < last; i++) {
+          T *row = matrices.row(g, i);
+          if (i == 0) {
+            for (uint64_t j = 0; j < N; j++) {
+              row[j] = 1.0 - (h * j);
+            }
+            row[N] = 0.0;
+          } else if (static_cast<uint64_t>(i) == N) {
+            row[0] = 0.0;
+            for (uint64_t j = 1; j <= N; j++) {
+              row[j] = h * j;
+            }
+          } else {
+            row[0] = 1.0 - (h * i);
+            row[N] = h * i;
+          }
         }
-        this->matrices[g, N, 0] = 0.0;
-        this->matrices[g, 0, N] = 0.0;
       }
+    };
+    std::vector<std::jthread> threads;
+    for (uint64_t t = 1; t < this->num_threads; t++) {
+      threads.emplace_back(init_band, t);
     }
+    init_band(0);
   }
 
 } // namespace partdiff
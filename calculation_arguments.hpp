@@ -1,22 +1,73 @@
 #pragma once
 
 #include "calculation_options.hpp"
+#include "convergence_check.hpp"
 #include "enums.hpp"
+#include "perturbation_source.hpp"
+#include "solve_control.hpp"
 #include "tensor.hpp"
+#include "tensor_pool.hpp"
+#include <array>
+#include <utility>
 
 namespace partdiff {
 
+  // The 9x9 values of the grid that are displayed after the calculation.
+  using matrix_sample = std::array<std::array<double, 9>, 9>;
+
   struct calculation_arguments {
 
     uint64_t N;
+    // The rows [first_row, last_row] that this process stores: the interior rows of its slab plus a halo or boundary
+    // row on either side. Without MPI, that is the whole grid.
+    uint64_t first_row;
+    uint64_t last_row;
     uint64_t num_matrices;
+    uint64_t num_threads;
+    uint64_t element_size;
     double h;
+    // Only one of them is allocated, depending on the storage precision.
     tensor matrices;
-    calculation_arguments(const calculation_options &);
+    basic_tensor<float> matrices_float;
+    perturbation_source perturbation;
+    // The state that calculate() starts from: the matrix holding the current values and the statistics so far. They
+    // only differ from a fresh start when resuming from a checkpoint.
+    int initial_m;
+    uint64_t initial_iteration = 0;
+    double initial_accuracy = 0.0;
+    convergence_check::state initial_check = {};
+    // The time it took to allocate and initialize the matrices, or to load them from a checkpoint.
+    double setup_seconds = 0.0;
+    // The caller's hook into a calculation that runs in the background, if any. See solve_control.
+    solve_control *control = nullptr;
+    calculation_arguments(const calculation_options &, int rank = 0, int num_ranks = 1);
+    // Takes the matrices from the pool if it holds some of the right shape. release_matrices() returns them.
+    calculation_arguments(const calculation_options &, tensor_pool &pool);
+
+    // Hands the matrices over to the pool, after which they must not be used any more.
+    void release_matrices(tensor_pool &pool);
+
+    // The value of an element, regardless of the storage precision.
+    double value(uint64_t matrix, uint64_t row, uint64_t col) const;
+
+    // The displayed values of matrix m. The rows that belong to another MPI rank are 0.0, so that the samples of all
+    // ranks add up to the complete one.
+    matrix_sample sample(int m, uint64_t interlines) const;
+
+    // The band of interior rows [first, second) of the slab that a thread works on. The matrices are first touched with
+    // the same partitioning, so that every thread finds its rows in local memory.
+    std::pair<int, int> row_band(int thread_id) const;
 
     private:
     perturbation_function pert_func;
-    void init_matrices();
+    storage_precision precision;
+    bool huge_pages;
+    calculation_arguments(const calculation_options &, int rank, int num_ranks, tensor_pool *pool);
+    tensor_pool::shape shape() const;
+    // Fills the matrices with their initial values, where zeroed says that they are fresh and still all zeros. Every
+    // thread initializes its own band of rows, which it thereby touches first, including the boundary values in it.
+    template <typename T>
+    void init_matrices(basic_tensor<T> &matrices, bool zeroed);
   };
 
 } // namespace partdiff
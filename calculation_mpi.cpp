@@ -0,0 +1,185 @@
+#include "calculation_mpi.hpp"
+#include "convergence_check.hpp"
+#include "enums.hpp"
+#include "kernels.hpp"
+#include <algorithm>
+#include <array>
+#include <mpi.h>
+#include <print>
+#include <type_traits>
+
+namespace partdiff {
+
+  namespace {
+
+    template <typename T>
+    MPI_Datatype mpi_type() {
+      return std::is_same_v<T, double> ? MPI_DOUBLE : MPI_FLOAT;
+    }
+
+    template <typename T>
+    calculation_results calculate_mpi(basic_tensor<T> &matrices, calculation_arguments &arguments,
+                                      const calculation_options &options) {
+
+      const auto now = std::chrono::high_resolution_clock::now;
+
+      const auto start_time = now();
+
+      uint64_t stat_iteration = 0;
+      double stat_accuracy = 0.0;
+
+      const int N = arguments.N;
+
+      // In accuracy mode, term_iteration caps the run, as in calculate().
+      int term_iteration = options.term_iteration;
+
+      int m1 = 0;
+      int m2 = (options.method == calculation_method::jacobi) ? 1 : 0;
+
+      int rank;
+      int num_ranks;
+      MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+      MPI_Comm_size(MPI_COMM_WORLD, &num_ranks);
+      // The first and last rank exchange nothing across the outer boundary.
+      const int rank_above = (rank > 0) ? rank - 1 : MPI_PROC_NULL;
+      const int rank_below = (rank < num_ranks - 1) ? rank + 1 : MPI_PROC_NULL;
+      const int i_begin = arguments.first_row + 1;
+      const int i_end = arguments.last_row;
+
+      const simd_kernel simd = resolve_simd_kernel(options.kernel);
+      const std::array<sweep_kernel<T>, 2> kernels = {
+          select_kernel<T>(options.method, options.pert_func, false, 0, simd, options.precision),
+          select_kernel<T>(options.method, options.pert_func, false, 1, simd, options.precision),
+      };
+      const std::array<sweep_kernel<T>, 2> residuum_kernels = {
+          select_kernel<T>(options.method, options.pert_func, true, 0, simd, options.precision),
+          select_kernel<T>(options.method, options.pert_func, true, 1, simd, options.precision),
+      };
+
+      // Sweeps the slab and refreshes the halo rows of m1 with the new edge rows of the neighbours. The edge rows of
+      // the slab are swept first, so that they travel while the interior is swept.
+      const auto sweep_and_exchange = [&](const sweep_kernel<T> kernel) {
+        double maxresiduum = kernel(matrices, m1, m2, {i_begin, i_begin + 1, 1, N}, arguments.perturbation, 1.0);
+        if (i_end - 1 > i_begin) {
+          const double edge_maxresiduum =
+              kernel(matrices, m1, m2, {i_end - 1, i_end, 1, N}, arguments.perturbation, 1.0);
+          maxresiduum = std::max(edge_maxresiduum, maxresiduum);
+        }
+
+        std::array<MPI_Request, 4> requests;
+        MPI_Irecv(matrices.row(m1, i_begin - 1), N + 1, mpi_type<T>(), rank_above, 0, MPI_COMM_WORLD, &requests[0]);
+        MPI_Irecv(matrices.row(m1, i_end), N + 1, mpi_type<T>(), rank_below, 0, MPI_COMM_WORLD, &requests[1]);
+        MPI_Isend(matrices.row(m1, i_begin), N + 1, mpi_type<T>(), rank_above, 0, MPI_COMM_WORLD, &requests[2]);
+        MPI_Isend(matrices.row(m1, i_end - 1), N + 1, mpi_type<T>(), rank_below, 0, MPI_COMM_WORLD, &requests[3]);
+
+        if (i_end - 1 > i_begin + 1) {
+          const double interior_maxresiduum =
+              kernel(matrices, m1, m2, {i_begin + 1, i_end - 1, 1, N}, arguments.perturbation, 1.0);
+          maxresiduum = std::max(interior_maxresiduum, maxresiduum);
+        }
+
+        MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+        return maxresiduum;
+      };
+
+      // All ranks see the same residua, so they agree on the sweeps that check for convergence.
+      convergence_check check(options, stat_iteration);
+
+      while (term_iteration > 0) {
+        // Only the last sweep needs the residuum, and in accuracy mode the checking ones.
+        const bool check_due = (options.termination == termination_condition::accuracy && check.due(stat_iteration));
+        const bool compute_residuum = check_due || term_iteration == 1;
+        const auto &kernel = compute_residuum ? residuum_kernels : kernels;
+
+        double maxresiduum = sweep_and_exchange(kernel[0]);
+        if (options.method == calculation_method::red_black) {
+          maxresiduum = std::max(sweep_and_exchange(kernel[1]), maxresiduum);
+        }
+
+        if (compute_residuum) {
+          MPI_Allreduce(MPI_IN_PLACE, &maxresiduum, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+        }
+
+        stat_iteration++;
+        if (compute_residuum || options.termination == termination_condition::iterations) {
+          stat_accuracy = maxresiduum;
+        }
+
+        const int temp = m1;
+        m1 = m2;
+        m2 = temp;
+
+        term_iteration--;
+        if (options.termination == termination_condition::accuracy) {
+          if (compute_residuum && check.converged(stat_iteration, maxresiduum)) {
+            term_iteration = 0;
+          }
+        }
+      }
+
+      const auto end_time = now();
+
+      calculation_results results = {m2, stat_iteration, stat_accuracy, start_time, end_time};
+      return results;
+    }
+
+  } // namespace
+
+  bool mpi_supported(const calculation_options &options, const int rank, const int num_ranks) {
+    const uint64_t N = (options.interlines * 8) + 9 - 1;
+    const auto fail = [rank](const auto &reason) {
+      if (rank == 0) {
+        std::println("MPI failure! ({})", reason);
+      }
+      return false;
+    };
+    if (options.method != calculation_method::jacobi && options.method != calculation_method::red_black) {
+      return fail(std::format("{:s} can't be distributed", options.method));
+    }
+    if (options.number != 1) {
+      return fail("every rank runs one thread, so num has to be 1");
+    }
+    if (options.tile_depth > 1) {
+      return fail("temporal tiling is not supported");
+    }
+    if (!options.checkpoint_path.empty() || !options.resume_path.empty()) {
+      return fail("checkpoints are not supported");
+    }
+    if (!options.trace_path.empty()) {
+      return fail("traces are not supported");
+    }
+    if (options.perf) {
+      return fail("hardware counters are not supported");
+    }
+    if (options.nested) {
+      return fail("nested iteration is not supported");
+    }
+    if (options.adaptive) {
+      return fail("adaptive sweeps are not supported");
+    }
+    if (options.fused) {
+      return fail("fused sweeps are not supported");
+    }
+    if (N - 1 < static_cast<uint64_t>(num_ranks)) {
+      return fail(std::format("{} ranks for {} rows", num_ranks, N - 1));
+    }
+    return true;
+  }
+
+  calculation_results calculate_mpi(calculation_arguments &arguments, const calculation_options &options) {
+    if (options.precision == storage_precision::double_precision) {
+      return calculate_mpi(arguments.matrices, arguments, options);
+    }
+    return calculate_mpi(arguments.matrices_float, arguments, options);
+  }
+
+  matrix_sample gather_sample(const calculation_arguments &arguments, const calculation_results &results,
+                              const calculation_options &options) {
+    const matrix_sample local = arguments.sample(results.m, options.interlines);
+    matrix_sample sample{};
+    // Every value comes from exactly one rank and is 0.0 on all others, so the sum is exact.
+    MPI_Reduce(local.data(), sample.data(), 9 * 9, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    return sample;
+  }
+
+} // namespace partdiff
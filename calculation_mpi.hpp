@@ -0,0 +1,21 @@
+#pragma once
+
+#include "calculation_arguments.hpp"
+#include "calculation_options.hpp"
+#include "calculation_results.hpp"
+
+namespace partdiff {
+
+  // Checks whether the calculation can be distributed and prints the reason on rank 0 if it can't. Only Jacobi and
+  // red-black Gauß-Seidel are supported, because their sweeps only need the rows of the neighbouring ranks from the
+  // previous (half-)sweep.
+  bool mpi_supported(const calculation_options &options, int rank, int num_ranks);
+
+  // Runs the calculation on the slab of this rank, with one thread per rank. Every rank returns the same statistics.
+  calculation_results calculate_mpi(calculation_arguments &arguments, const calculation_options &options);
+
+  // Collects the displayed values of all ranks on rank 0.
+  matrix_sample gather_sample(const calculation_arguments &arguments, const calculation_results &results,
+                              const calculation_options &options);
+
+} // namespace partdiff
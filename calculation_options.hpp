@@ -2,17 +2,40 @@
 
 #include "enums.hpp"
 #include <cstdint>
+#include <string>
 
 namespace partdiff {
 
+  // The defaults are those of the command line options, so that a calculation_options built with designated
+  // initializers only has to name the problem and what differs from partdiff's defaults.
   struct calculation_options {
-    uint64_t number;
-    uint64_t interlines;
-    calculation_method method;
-    perturbation_function pert_func;
-    termination_condition termination;
-    uint64_t term_iteration;
-    double term_accuracy;
+    uint64_t number = 1;
+    uint64_t interlines = 0;
+    calculation_method method = calculation_method::jacobi;
+    perturbation_function pert_func = perturbation_function::f0;
+    termination_condition termination = termination_condition::iterations;
+    // The iterations to run, and in accuracy mode the most before giving up, as with partdiff's accuracy runs. Both
+    // include the iterations of the run that wrote the checkpoint to resume from.
+    uint64_t term_iteration = 200000;
+    double term_accuracy = 0.0;
+    simd_kernel kernel = simd_kernel::automatic;
+    uint64_t tile_depth = 0;
+    bool huge_pages = false;
+    storage_precision precision = storage_precision::double_precision;
+    double omega = 0.0;
+    std::string checkpoint_path{};
+    uint64_t checkpoint_every = 1000;
+    std::string resume_path{};
+    uint64_t check_every = 1;
+    std::string trace_path{};
+    uint64_t trace_every = 1;
+    uint64_t trace_size = 65536;
+    bool perf = false;
+    std::string field_path{};
+    bool setup_time = false;
+    bool nested = false;
+    bool adaptive = false;
+    bool fused = false;
   };
 
 } // namespace partdiff
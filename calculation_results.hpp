@@ -1,6 +1,9 @@
 #pragma once
 
+#include "perf_counters.hpp"
 #include <chrono>
+#include <string>
+#include <vector>
 
 namespace partdiff {
 
@@ -11,6 +14,9 @@ namespace partdiff {
     double stat_accuracy;
     time_point start_time;
     time_point end_time;
+    // With --perf, the hardware counters of every thread, or the reason why there are none.
+    std::vector<perf_sample> perf_samples = {};
+    std::string perf_error = {};
   };
 
 } // namespace partdiff
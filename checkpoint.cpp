@@ -0,0 +1,188 @@
+#include "checkpoint.hpp"
+#include "failure.hpp"
+#include "file_descriptor.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <format>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace partdiff {
+
+  static constexpr char checkpoint_magic[8] = {'P', 'D', 'I', 'F', 'F', 'C', 'P', '1'};
+
+  static checkpoint_header read_checkpoint_header(const file_descriptor &fd, const std::string &path) {
+    checkpoint_header header;
+    if (!fd.valid() || pread(fd.get(), &header, sizeof(header), 0) != sizeof(header) ||
+        std::memcmp(header.magic, checkpoint_magic, sizeof(checkpoint_magic)) != 0) {
+      fail(std::format("Checkpoint failure! ({} is not a readable checkpoint)", path));
+    }
+    return header;
+  }
+
+  checkpoint_writer::checkpoint_writer(const std::string &path, const calculation_options &options,
+                                       const calculation_arguments &arguments)
+    : path(path),
+      num_matrices(arguments.num_matrices),
+      row_size((arguments.N + 1) * arguments.element_size) {
+    // The whole header goes to disk, so any padding in it must not hold leftover memory.
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, checkpoint_magic, sizeof(checkpoint_magic));
+    header.interlines = options.interlines;
+    header.method = options.method;
+    header.pert_func = options.pert_func;
+    header.precision = options.precision;
+    header.num_matrices = arguments.num_matrices;
+    header.data_size = (options.precision == storage_precision::double_precision)
+                           ? arguments.matrices.elements().size_bytes()
+                           : arguments.matrices_float.elements().size_bytes();
+    for (auto &snapshot : this->snapshots) {
+      snapshot.resize(checkpoint_data_offset + header.data_size);
+    }
+    this->writer = std::jthread([this] { this->write_loop(); });
+  }
+
+  checkpoint_writer::~checkpoint_writer() {
+    this->stop();
+  }
+
+  void checkpoint_writer::finish() {
+    this->stop();
+    if (this->writer.joinable()) {
+      this->writer.join();
+    }
+    if (this->write_failed.load()) {
+      fail(std::format("Checkpoint failure! (Could not write {})", this->path));
+    }
+  }
+
+  void checkpoint_writer::stop() noexcept {
+    this->stopping.store(true);
+    this->published.fetch_add(1);
+    this->published.notify_one();
+  }
+
+  void checkpoint_writer::begin(const int m, const uint64_t stat_iteration, const double stat_accuracy,
+                                const convergence_check::state &check, const int num_bands) noexcept {
+    // A queued snapshot that the writer hasn't started on is replaced, so there is at most one. Since the writer works
+    // on at most one other snapshot, one of them is always queued or free.
+    const auto claim = [this](const snapshot_state from) {
+      for (int s = 0; s < 2; s++) {
+        snapshot_state expected = from;
+        if (this->states[s].compare_exchange_strong(expected, snapshot_state::filling)) {
+          this->current = s;
+          return true;
+        }
+      }
+      return false;
+    };
+    if (!claim(snapshot_state::queued)) {
+      claim(snapshot_state::free);
+    }
+    this->header.m = m;
+    this->header.stat_iteration = stat_iteration;
+    this->header.stat_accuracy = stat_accuracy;
+    this->header.check = check;
+    std::memcpy(this->snapshots[this->current].data(), &this->header, sizeof(this->header));
+    this->pending_bands.store(num_bands);
+  }
+
+  template <typename T>
+  void checkpoint_writer::save_rows(const basic_tensor<T> &matrices, const int first_row, const int last_row) {
+    const T *elements = matrices.elements().data();
+    std::byte *data = this->snapshots[this->current].data() + checkpoint_data_offset;
+    for (uint64_t m = 0; m < this->num_matrices; m++) {
+      for (int i = first_row; i < last_row; i++) {
+        const T *row = matrices.row(m, i);
+        std::memcpy(data + (row - elements) * sizeof(T), row, this->row_size);
+      }
+    }
+    if (this->pending_bands.fetch_sub(1) == 1) {
+      this->states[this->current].store(snapshot_state::queued);
+      this->published.fetch_add(1);
+      this->published.notify_one();
+    }
+  }
+
+  void checkpoint_writer::write_loop() {
+    while (true) {
+      const uint64_t seen = this->published.load();
+      bool wrote = false;
+      for (std::size_t s = 0; s < this->snapshots.size(); s++) {
+        snapshot_state expected = snapshot_state::queued;
+        if (this->states[s].compare_exchange_strong(expected, snapshot_state::writing)) {
+          if (!this->write_snapshot(this->snapshots[s])) {
+            this->write_failed.store(true);
+          }
+          this->states[s].store(snapshot_state::free);
+          wrote = true;
+        }
+      }
+      if (!wrote) {
+        if (this->stopping.load()) {
+          return;
+        }
+        this->published.wait(seen);
+      }
+    }
+  }
+
+  bool checkpoint_writer::write_snapshot(const std::vector<std::byte> &snapshot) const {
+    static constexpr std::size_t chunk_size = 64 * 1024 * 1024;
+    const std::string temp_path = this->path + ".tmp";
+    file_descriptor fd(open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644));
+    bool success = fd.valid();
+    for (std::size_t written = 0; success && written < snapshot.size();) {
+      const std::size_t count = std::min(chunk_size, snapshot.size() - written);
+      const ssize_t result = write(fd.get(), snapshot.data() + written, count);
+      success = (result > 0);
+      written += success ? result : 0;
+    }
+    success = success && (fsync(fd.get()) == 0);
+    success = fd.close() && success;
+    return success && (rename(temp_path.c_str(), this->path.c_str()) == 0);
+  }
+
+  void read_checkpoint_options(const std::string &path, calculation_options &options) {
+    const file_descriptor fd(open(path.c_str(), O_RDONLY));
+    const checkpoint_header header = read_checkpoint_header(fd, path);
+    options.interlines = header.interlines;
+    options.method = header.method;
+    options.pert_func = header.pert_func;
+    options.precision = header.precision;
+  }
+
+  void load_checkpoint(const std::string &path, calculation_arguments &arguments) {
+    file_descriptor fd(open(path.c_str(), O_RDONLY));
+    const checkpoint_header header = read_checkpoint_header(fd, path);
+    const uint64_t N = arguments.N;
+    struct stat file_status;
+    if (header.num_matrices != arguments.num_matrices || fstat(fd.get(), &file_status) != 0 ||
+        static_cast<uint64_t>(file_status.st_size) < checkpoint_data_offset + header.data_size) {
+      fail(std::format("Checkpoint failure! ({} does not match the calculation)", path));
+    }
+    std::size_t data_size;
+    if (header.precision == storage_precision::double_precision) {
+      arguments.matrices = tensor(fd.get(), checkpoint_data_offset, header.num_matrices, N + 1, N + 1);
+      data_size = arguments.matrices.elements().size_bytes();
+    } else {
+      arguments.matrices_float =
+          basic_tensor<float>(fd.get(), checkpoint_data_offset, header.num_matrices, N + 1, N + 1);
+      data_size = arguments.matrices_float.elements().size_bytes();
+    }
+    if (data_size != header.data_size) {
+      fail(std::format("Checkpoint failure! ({} does not match the calculation)", path));
+    }
+    // The mapping stays valid after the file is closed.
+    fd.close();
+    arguments.initial_m = header.m;
+    arguments.initial_iteration = header.stat_iteration;
+    arguments.initial_accuracy = header.stat_accuracy;
+    arguments.initial_check = header.check;
+  }
+
+  template void checkpoint_writer::save_rows(const basic_tensor<double> &, int, int);
+  template void checkpoint_writer::save_rows(const basic_tensor<float> &, int, int);
+
+} // namespace partdiff
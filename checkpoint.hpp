@@ -0,0 +1,94 @@
+#pragma once
+
+#include "calculation_arguments.hpp"
+#include "calculation_options.hpp"
+#include "convergence_check.hpp"
+#include "tensor.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace partdiff {
+
+  // A checkpoint consists of a header that describes the problem and the solver state, padded to one page, followed
+  // by the raw elements of the tensor in memory order. Because the elements start on a page boundary, a checkpoint
+  // can be mapped straight back into a tensor.
+  struct checkpoint_header {
+    char magic[8];
+    uint64_t interlines;
+    calculation_method method;
+    perturbation_function pert_func;
+    storage_precision precision;
+    uint64_t num_matrices;
+    uint64_t data_size;
+    int64_t m;
+    uint64_t stat_iteration;
+    double stat_accuracy;
+    convergence_check::state check;
+  };
+
+  static constexpr std::size_t checkpoint_data_offset = 4096;
+
+  // Writes checkpoints in the background. A writer thread, started with the writer, takes complete snapshots of the
+  // tensor out of two buffers, so that one of them is always free to be filled: begin() claims a buffer for the state
+  // after stat_iteration, and every thread copies its band of rows into it with save_rows(), after which the last one
+  // hands the snapshot to the writer. If the writer is still busy with a previous checkpoint, a snapshot that it
+  // hasn't started on yet is replaced by the newer one, so the sweeps never wait for the file system. The snapshot
+  // goes to a temporary file that replaces the previous checkpoint once it is complete, so a crash never leaves a torn
+  // checkpoint behind.
+  class checkpoint_writer {
+    public:
+    checkpoint_writer(const std::string &path, const calculation_options &options,
+                      const calculation_arguments &arguments);
+    // Writes the last snapshot, if there is one left.
+    ~checkpoint_writer();
+    checkpoint_writer(const checkpoint_writer &) = delete;
+    checkpoint_writer &operator=(const checkpoint_writer &) = delete;
+    // Starts a snapshot that num_bands calls to save_rows() fill. It neither blocks nor allocates, so it may run in a
+    // barrier completion, but it must not overlap with the save_rows() calls of the previous snapshot. check is the
+    // state of the convergence check, if the solver has one.
+    void begin(int m, uint64_t stat_iteration, double stat_accuracy, const convergence_check::state &check,
+               int num_bands) noexcept;
+    // Copies the rows [first_row, last_row) of all matrices into the snapshot.
+    template <typename T>
+    void save_rows(const basic_tensor<T> &matrices, int first_row, int last_row);
+    // Whether the writer failed to write a checkpoint, after which the calculation should stop and call finish().
+    bool failed() const noexcept {
+      return this->write_failed.load();
+    }
+    // Writes the last snapshot and stops the writer. A checkpoint that could not be written ends the calculation with
+    // fail(), on the calling thread.
+    void finish();
+
+    private:
+    enum class snapshot_state { free, filling, queued, writing };
+    std::string path;
+    checkpoint_header header;
+    uint64_t num_matrices;
+    std::size_t row_size;
+    std::array<std::vector<std::byte>, 2> snapshots;
+    std::array<std::atomic<snapshot_state>, 2> states = {snapshot_state::free, snapshot_state::free};
+    int current = 0;
+    std::atomic<int> pending_bands = 0;
+    // Counts the snapshots handed to the writer, which waits for it to change.
+    std::atomic<uint64_t> published = 0;
+    std::atomic<bool> stopping = false;
+    std::atomic<bool> write_failed = false;
+    std::jthread writer;
+    void stop() noexcept;
+    void write_loop();
+    bool write_snapshot(const std::vector<std::byte> &snapshot) const;
+  };
+
+  // Replaces the problem description in options with the one stored in the checkpoint at path. The termination
+  // condition is left alone, so a resumed run can go on for longer than the one that wrote the checkpoint.
+  void read_checkpoint_options(const std::string &path, calculation_options &options);
+
+  // Maps the tensor of the checkpoint at path into arguments and restores the solver state.
+  void load_checkpoint(const std::string &path, calculation_arguments &arguments);
+
+} // namespace partdiff
@@ -0,0 +1,137 @@
+#include "conjugate_gradient.hpp"
+#include "enums.hpp"
+#include "iteration_loop.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace partdiff {
+
+  namespace {
+
+    // The interior points form the system A u = b with A = I - 0.25 * (sum of the neighbours), which is symmetric
+    // positive definite. The boundary values are known, so they move to the right-hand side b together with the
+    // perturbation. The vectors of CG live on full grids with a zero boundary, so that A can be applied with the
+    // same stencil everywhere. Its diagonal is 1, so a Jacobi preconditioner would change nothing.
+
+    // Sets r = b - A u and returns the maximum norm of r.
+    template <typename T>
+    double compute_residual(basic_tensor<T> &u, tensor &r, const int N, const perturbation_source &perturbation) {
+      double maxresiduum = 0.0;
+      for (int i = 1; i < N; i++) {
+        const T *centre = u.row(0, i);
+        const T *above = u.row(0, i - 1);
+        const T *below = u.row(0, i + 1);
+        double *residual = r.row(0, i);
+        for (int j = 1; j < N; j++) {
+          double star = 0.25 * ((double)above[j] + (double)centre[j - 1] + (double)centre[j + 1] + (double)below[j]);
+          if (perturbation.enabled()) {
+            star += perturbation.row_factors[i] * perturbation.col_factors[j];
+          }
+          residual[j] = star - (double)centre[j];
+          maxresiduum = std::max(std::fabs(residual[j]), maxresiduum);
+        }
+      }
+      return maxresiduum;
+    }
+
+    void zero(tensor &v, const int N) {
+      for (int i = 0; i <= N; i++) {
+        std::fill(v.row(0, i), v.row(0, i) + N + 1, 0.0);
+      }
+    }
+
+    template <typename T>
+    calculation_results calculate_conjugate_gradient(basic_tensor<T> &matrices, calculation_arguments &arguments,
+                                                     const calculation_options &options) {
+
+      const auto start_time = std::chrono::high_resolution_clock::now();
+
+      const int N = arguments.N;
+
+      tensor r(1, N + 1, N + 1);
+      tensor p(1, N + 1, N + 1);
+      tensor q(1, N + 1, N + 1);
+      zero(r, N);
+      zero(p, N);
+      zero(q, N);
+
+      compute_residual(matrices, r, N, arguments.perturbation);
+      double rr = 0.0;
+      for (int i = 1; i < N; i++) {
+        const double *residual = r.row(0, i);
+        double *direction = p.row(0, i);
+        for (int j = 1; j < N; j++) {
+          direction[j] = residual[j];
+          rr += residual[j] * residual[j];
+        }
+      }
+
+      iteration_loop loop(arguments, options, start_time);
+
+      while (loop.running()) {
+        loop.begin_iteration();
+
+        // q = A p
+        double pq = 0.0;
+        for (int i = 1; i < N; i++) {
+          const double *centre = p.row(0, i);
+          const double *above = p.row(0, i - 1);
+          const double *below = p.row(0, i + 1);
+          double *product = q.row(0, i);
+          for (int j = 1; j < N; j++) {
+            product[j] = centre[j] - 0.25 * (above[j] + centre[j - 1] + centre[j + 1] + below[j]);
+            pq += centre[j] * product[j];
+          }
+        }
+
+        // Once the residual is exactly zero, there is no direction left to go.
+        const double alpha = (pq > 0.0) ? rr / pq : 0.0;
+        double rr_next = 0.0;
+        double maxresiduum = 0.0;
+        for (int i = 1; i < N; i++) {
+          T *solution = matrices.row(0, i);
+          const double *direction = p.row(0, i);
+          const double *product = q.row(0, i);
+          double *residual = r.row(0, i);
+          for (int j = 1; j < N; j++) {
+            solution[j] = T((double)solution[j] + alpha * direction[j]);
+            residual[j] -= alpha * product[j];
+            rr_next += residual[j] * residual[j];
+            maxresiduum = std::max(std::fabs(residual[j]), maxresiduum);
+          }
+        }
+
+        const double beta = (rr > 0.0) ? rr_next / rr : 0.0;
+        rr = rr_next;
+        for (int i = 1; i < N; i++) {
+          const double *residual = r.row(0, i);
+          double *direction = p.row(0, i);
+          for (int j = 1; j < N; j++) {
+            direction[j] = residual[j] + beta * direction[j];
+          }
+        }
+
+        // Only the solution goes into the checkpoint, so a resumed run restarts CG from it.
+        loop.end_iteration(matrices, maxresiduum);
+      }
+
+      // The updated residual drifts away from the true one in floating point, so the reported residuum is recomputed
+      // from the solution.
+      if (loop.iteration() > arguments.initial_iteration) {
+        loop.set_accuracy(compute_residual(matrices, r, N, arguments.perturbation));
+      }
+
+      return loop.finish();
+    }
+
+  } // namespace
+
+  calculation_results calculate_conjugate_gradient(calculation_arguments &arguments,
+                                                   const calculation_options &options) {
+    if (options.precision == storage_precision::double_precision) {
+      return calculate_conjugate_gradient(arguments.matrices, arguments, options);
+    }
+    return calculate_conjugate_gradient(arguments.matrices_float, arguments, options);
+  }
+
+} // namespace partdiff
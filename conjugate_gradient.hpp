@@ -0,0 +1,16 @@
+#pragma once
+
+#include "calculation_arguments.hpp"
+#include "calculation_options.hpp"
+#include "calculation_results.hpp"
+
+namespace partdiff {
+
+  // Solves the system with the conjugate gradient method, applying the stencil on the fly. One CG step counts as one
+  // iteration. The residuum is the maximum norm of the residual of the scaled system
+  // u[i][j] = 0.25 * (sum of the neighbours) + f[i][j], i.e. the largest change that a Jacobi sweep would make, which
+  // is what the other methods report as well.
+  calculation_results calculate_conjugate_gradient(calculation_arguments &arguments,
+                                                   const calculation_options &options);
+
+} // namespace partdiff
@@ -0,0 +1,43 @@
+#include "convergence_check.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace partdiff {
+
+  convergence_check::convergence_check(const calculation_options &options, const uint64_t stat_iteration)
+    : term_accuracy(options.term_accuracy),
+      check_every(std::max<uint64_t>(options.check_every, 1)),
+      next_check(stat_iteration + 1) {}
+
+  convergence_check::convergence_check(const calculation_options &options, const state &saved)
+    : term_accuracy(options.term_accuracy),
+      check_every(std::max<uint64_t>(options.check_every, 1)),
+      next_check(saved.next_check),
+      interval(saved.interval),
+      last_iteration(saved.last_iteration),
+      last_residuum(saved.last_residuum) {}
+
+  bool convergence_check::due(const uint64_t stat_iteration) const {
+    return stat_iteration + 1 >= this->next_check;
+  }
+
+  bool convergence_check::converged(const uint64_t stat_iteration, const double residuum) {
+    if (residuum < this->term_accuracy) {
+      return true;
+    }
+
+    double next_interval = (double)std::min(2 * this->interval, this->check_every);
+    if (this->last_residuum > 0.0 && residuum < this->last_residuum && stat_iteration > this->last_iteration) {
+      const double rate = std::log(residuum / this->last_residuum) / (double)(stat_iteration - this->last_iteration);
+      const double remaining = std::log(this->term_accuracy / residuum) / rate;
+      next_interval = std::clamp(remaining / 2.0, 1.0, next_interval);
+    }
+
+    this->interval = static_cast<uint64_t>(next_interval);
+    this->last_iteration = stat_iteration;
+    this->last_residuum = residuum;
+    this->next_check = stat_iteration + this->interval;
+    return false;
+  }
+
+} // namespace partdiff
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "calculation_options.hpp"
+#include <cstdint>
+
+namespace partdiff {
+
+  // Decides which sweeps compute the residuum in accuracy mode. Computing it costs a fabs and a max per point and a
+  // reduction across the threads, so with check_every > 1 only every few sweeps compute it. After each check, the
+  // rate at which the residuum dropped since the previous check predicts how many sweeps are left until the accuracy
+  // is reached, and the next check comes after half of them, so the checks get denser as the residuum approaches the
+  // target. The interval at most doubles from one check to the next and never exceeds check_every. A check is a full
+  // sweep with the residuum kernels, so the run stops on exactly the same criterion as with a check in every sweep,
+  // only up to one check interval later.
+  class convergence_check {
+    public:
+    // What a checkpoint keeps of the check, so that a resumed run checks on the same sweeps as an uninterrupted one. An
+    // interval of 0 stands for no saved state.
+    struct state {
+      uint64_t next_check;
+      uint64_t interval;
+      uint64_t last_iteration;
+      double last_residuum;
+    };
+
+    convergence_check(const calculation_options &options, uint64_t stat_iteration);
+    convergence_check(const calculation_options &options, const state &saved);
+    state saved() const {
+      return {this->next_check, this->interval, this->last_iteration, this->last_residuum};
+    }
+    // Whether the sweep after stat_iteration has to compute the residuum.
+    bool due(uint64_t stat_iteration) const;
+    // Records the residuum of the sweep that ended with stat_iteration, and returns whether it is below the accuracy.
+    bool converged(uint64_t stat_iteration, double residuum);
+
+    private:
+    double term_accuracy;
+    uint64_t check_every;
+    uint64_t next_check;
+    uint64_t interval = 1;
+    uint64_t last_iteration = 0;
+    double last_residuum = 0.0;
+  };
+
+} // namespace partdiff
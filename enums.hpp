@@ -11,9 +11,18 @@
 #include <utility>
 
 namespace partdiff {
-  enum class calculation_method : uint64_t { gauss_seidel = 1, jacobi = 2 };
+  enum class calculation_method : uint64_t {
+    gauss_seidel = 1,
+    jacobi = 2,
+    red_black = 3,
+    multigrid = 4,
+    conjugate_gradient = 5,
+    sor = 6
+  };
   enum class perturbation_function : uint64_t { f0 = 1, fpisin = 2 };
   enum class termination_condition : uint64_t { accuracy = 1, iterations = 2 };
+  enum class simd_kernel : uint64_t { automatic = 0, scalar = 1, avx2 = 2, avx512 = 3 };
+  enum class storage_precision : uint64_t { double_precision = 1, mixed = 2, single_precision = 3 };
 
 } // namespace partdiff
 
@@ -25,6 +34,10 @@ struct enum_member_names<partdiff::calculation_method> {
   static constexpr std::array names = {
       std::pair{partdiff::calculation_method::gauss_seidel, "Gauß-Seidel"},
       std::pair{partdiff::calculation_method::jacobi, "Jacobi"},
+      std::pair{partdiff::calculation_method::red_black, "Red-Black Gauß-Seidel"},
+      std::pair{partdiff::calculation_method::multigrid, "Multigrid"},
+      std::pair{partdiff::calculation_method::conjugate_gradient, "Conjugate gradient"},
+      std::pair{partdiff::calculation_method::sor, "SOR"},
   };
 };
 
@@ -44,6 +57,25 @@ struct enum_member_names<partdiff::termination_condition> {
   };
 };
 
+template <>
+struct enum_member_names<partdiff::simd_kernel> {
+  static constexpr std::array names = {
+      std::pair{partdiff::simd_kernel::automatic, "automatic"},
+      std::pair{partdiff::simd_kernel::scalar, "scalar"},
+      std::pair{partdiff::simd_kernel::avx2, "AVX2"},
+      std::pair{partdiff::simd_kernel::avx512, "AVX-512"},
+  };
+};
+
+template <>
+struct enum_member_names<partdiff::storage_precision> {
+  static constexpr std::array names = {
+      std::pair{partdiff::storage_precision::double_precision, "double"},
+      std::pair{partdiff::storage_precision::mixed, "float storage, double arithmetic"},
+      std::pair{partdiff::storage_precision::single_precision, "float"},
+  };
+};
+
 // Some template magic to print the above enum classes with "{:d}" and "{:s}"
 
 template <typename Enum>
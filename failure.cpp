@@ -0,0 +1,25 @@
+#include "failure.hpp"
+#include <cstdlib>
+#include <print>
+
+namespace partdiff {
+
+  static thread_local int num_failure_guards = 0;
+
+  void fail(const std::string &message) {
+    if (num_failure_guards > 0) {
+      throw calculation_failure(message);
+    }
+    std::println("{}", message);
+    exit(EXIT_FAILURE);
+  }
+
+  failure_guard::failure_guard() {
+    num_failure_guards++;
+  }
+
+  failure_guard::~failure_guard() {
+    num_failure_guards--;
+  }
+
+} // namespace partdiff
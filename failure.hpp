@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+namespace partdiff {
+
+  // An error that ends a calculation, e.g. matrices that can't be allocated or a checkpoint that doesn't fit.
+  class calculation_failure : public std::runtime_error {
+    public:
+    using std::runtime_error::runtime_error;
+  };
+
+  // Ends the calculation with message. partdiff prints it and exits with EXIT_FAILURE, while on a thread that holds a
+  // failure_guard, it throws a calculation_failure, so that a program running many calculations survives it.
+  [[noreturn]] void fail(const std::string &message);
+
+  // Makes fail() throw on the current thread while it exists.
+  class failure_guard {
+    public:
+    failure_guard();
+    ~failure_guard();
+    failure_guard(const failure_guard &) = delete;
+    failure_guard &operator=(const failure_guard &) = delete;
+  };
+
+} // namespace partdiff
@@ -0,0 +1,85 @@
+#include "field_output.hpp"
+#include "failure.hpp"
+#include "file_descriptor.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <format>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace partdiff {
+
+  static constexpr char field_magic[8] = {'P', 'D', 'I', 'F', 'F', 'F', 'D', '1'};
+
+  template <typename T>
+  static void copy_rows(basic_tensor<T> &matrices, const int m, calculation_arguments &arguments, std::byte *data) {
+    const uint64_t N = arguments.N;
+    const std::size_t row_size = (N + 1) * sizeof(T);
+    const auto copy_band = [&](const int thread_id) {
+      auto [first, last] = arguments.row_band(thread_id);
+      // The boundary rows go with the outer bands, if this process owns them.
+      if (thread_id == 0 && arguments.first_row == 0) {
+        first = 0;
+      }
+      if (thread_id == static_cast<int>(arguments.num_threads) - 1 && arguments.last_row == N) {
+        last = N + 1;
+      }
+      for (int i = first; i < last; i++) {
+        std::memcpy(data + i * row_size, matrices.row(m, i), row_size);
+      }
+    };
+
+    std::vector<std::jthread> threads;
+    for (uint64_t t = 1; t < arguments.num_threads; t++) {
+      threads.emplace_back(copy_band, t);
+    }
+    copy_band(0);
+  }
+
+  void write_field(const std::string &path, calculation_arguments &arguments, const calculation_results &results,
+                   const calculation_options &options) {
+    const uint64_t N = arguments.N;
+    const std::size_t file_size = field_data_offset + (N + 1) * (N + 1) * arguments.element_size;
+
+    // Every MPI rank resizes the file to the same size, so it doesn't matter which one comes first.
+    file_descriptor fd(open(path.c_str(), O_RDWR | O_CREAT, 0644));
+    if (!fd.valid() || ftruncate(fd.get(), file_size) != 0) {
+      fail(std::format("Output failure! (Could not create {})", path));
+    }
+    void *mapping = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd.get(), 0);
+    if (mapping == MAP_FAILED) {
+      fail(std::format("Output failure! (Could not map {})", path));
+    }
+    std::byte *file = static_cast<std::byte *>(mapping);
+
+    if (arguments.first_row == 0) {
+      field_header header;
+      std::memset(&header, 0, sizeof(header));
+      std::memcpy(header.magic, field_magic, sizeof(field_magic));
+      header.rows = N + 1;
+      header.cols = N + 1;
+      header.element_size = arguments.element_size;
+      header.interlines = options.interlines;
+      header.method = options.method;
+      header.pert_func = options.pert_func;
+      header.stat_iteration = results.stat_iteration;
+      header.stat_accuracy = results.stat_accuracy;
+      std::memcpy(file, &header, sizeof(header));
+    }
+
+    if (options.precision == storage_precision::double_precision) {
+      copy_rows(arguments.matrices, results.m, arguments, file + field_data_offset);
+    } else {
+      copy_rows(arguments.matrices_float, results.m, arguments, file + field_data_offset);
+    }
+
+    const bool synced = (msync(mapping, file_size, MS_SYNC) == 0);
+    munmap(mapping, file_size);
+    if (!synced || !fd.close()) {
+      fail(std::format("Output failure! (Could not write {})", path));
+    }
+  }
+
+} // namespace partdiff
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "calculation_arguments.hpp"
+#include "calculation_options.hpp"
+#include "calculation_results.hpp"
+#include "enums.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace partdiff {
+
+  // A field file holds the whole solution: this header, padded to one page, followed by the rows x cols elements of
+  // the grid in row-major order without any padding, stored as float (element_size 4) or double (element_size 8) in
+  // native byte order. For example, numpy reads it with
+  // np.fromfile(path, dtype, offset=4096).reshape(rows, cols).
+  struct field_header {
+    char magic[8];
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t element_size;
+    uint64_t interlines;
+    calculation_method method;
+    perturbation_function pert_func;
+    uint64_t stat_iteration;
+    double stat_accuracy;
+  };
+
+  static constexpr std::size_t field_data_offset = 4096;
+
+  // Writes the rows of matrix results.m that this process owns to the field file at path. The file is mapped and
+  // every thread copies its own band of rows into it, so the writes are large, sequential and come from the memory
+  // the thread first touched. With MPI, every rank calls this with its slab and the ranks fill disjoint regions of
+  // the same file.
+  void write_field(const std::string &path, calculation_arguments &arguments, const calculation_results &results,
+                   const calculation_options &options);
+
+} // namespace partdiff
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <unistd.h>
+
+namespace partdiff {
+
+  // Owns a file descriptor from open() and closes it when it goes out of scope, also when fail() throws on the way.
+  // A negative descriptor, i.e. a failed open(), is held as well and simply not closed.
+  class file_descriptor {
+    public:
+    explicit file_descriptor(const int fd) : fd(fd) {}
+    ~file_descriptor() {
+      this->close();
+    }
+    file_descriptor(const file_descriptor &) = delete;
+    file_descriptor &operator=(const file_descriptor &) = delete;
+
+    int get() const {
+      return this->fd;
+    }
+    bool valid() const {
+      return this->fd >= 0;
+    }
+    // Closes the descriptor early, and returns whether that succeeded, which for a written file is the last chance to
+    // learn of a failed write.
+    bool close() {
+      const int fd = this->fd;
+      this->fd = -1;
+      return fd < 0 || ::close(fd) == 0;
+    }
+
+    private:
+    int fd;
+  };
+
+} // namespace partdiff
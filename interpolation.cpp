@@ -0,0 +1,15 @@
+#include "interpolation.hpp"
+#include <algorithm>
+#include <cstdint>
+
+namespace partdiff {
+
+  interpolation::interpolation(const int n_fine, const int n_coarse) : index(n_fine + 1), weight(n_fine + 1) {
+    for (int k = 0; k <= n_fine; k++) {
+      const int64_t position = static_cast<int64_t>(k) * n_coarse;
+      this->index[k] = std::min(static_cast<int>(position / n_fine), n_coarse - 1);
+      this->weight[k] = (double)(position - static_cast<int64_t>(this->index[k]) * n_fine) / n_fine;
+    }
+  }
+
+} // namespace partdiff
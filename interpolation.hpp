@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+
+namespace partdiff {
+
+  // The bilinear interpolation from a grid with n_coarse intervals to one with n_fine intervals, per dimension: fine
+  // point k lies between the coarse points index[k] and index[k] + 1, with the weights 1 - weight[k] and weight[k].
+  // For n_fine = 2 * n_coarse this is the usual prolongation. Grids whose size is not a power of two eventually
+  // halve an odd number of intervals, and from there on the grids are not nested, which the interpolation handles
+  // just the same.
+  struct interpolation {
+    std::vector<int> index;
+    std::vector<double> weight;
+
+    interpolation(int n_fine, int n_coarse);
+  };
+
+} // namespace partdiff
@@ -0,0 +1,86 @@
+#include "iteration_loop.hpp"
+#include <chrono>
+#include <span>
+
+namespace partdiff {
+
+  static const auto now = std::chrono::high_resolution_clock::now;
+
+  iteration_loop::iteration_loop(calculation_arguments &arguments, const calculation_options &options,
+                                 const calculation_results::time_point start_time)
+    : options(options),
+      control(arguments.control),
+      N(arguments.N),
+      start_time(start_time),
+      stat_iteration(arguments.initial_iteration),
+      stat_accuracy(arguments.initial_accuracy),
+      term_iteration(static_cast<int>(options.term_iteration) - static_cast<int>(arguments.initial_iteration)),
+      trace(options),
+      next_checkpoint(arguments.initial_iteration + options.checkpoint_every) {
+    if (!options.checkpoint_path.empty() && options.checkpoint_every > 0) {
+      this->checkpoint.emplace(options.checkpoint_path, options, arguments);
+    }
+    if (options.perf) {
+      this->counters.emplace();
+      this->counters->start();
+    }
+  }
+
+  void iteration_loop::begin_iteration() {
+    this->traced = this->trace.due(this->stat_iteration);
+    if (this->traced) {
+      this->iteration_begin = now();
+    }
+  }
+
+  template <typename T>
+  void iteration_loop::end_iteration(const basic_tensor<T> &matrices, const double residuum) {
+    this->stat_iteration++;
+    this->stat_accuracy = residuum;
+
+    if (this->traced) {
+      const double seconds = std::chrono::duration<double>(now() - this->iteration_begin).count();
+      this->trace.record(this->stat_iteration, seconds, residuum, std::span<const double>(&seconds, 1));
+    }
+    if (this->control && this->control->due(this->stat_iteration - 1)) {
+      this->control->report(this->stat_iteration, residuum);
+    }
+
+    this->term_iteration--;
+    if (this->options.termination == termination_condition::accuracy && residuum < this->options.term_accuracy) {
+      this->term_iteration = 0;
+    }
+    if (this->control && this->control->cancelled()) {
+      this->term_iteration = 0;
+    }
+    if (this->checkpoint && this->checkpoint->failed()) {
+      this->term_iteration = 0;
+    }
+
+    if (this->checkpoint && this->term_iteration > 0 && this->stat_iteration >= this->next_checkpoint) {
+      this->checkpoint->begin(0, this->stat_iteration, this->stat_accuracy, {}, 1);
+      this->checkpoint->save_rows(matrices, 0, this->N + 1);
+      this->next_checkpoint = this->stat_iteration + this->options.checkpoint_every;
+    }
+  }
+
+  calculation_results iteration_loop::finish() {
+    const auto end_time = now();
+    if (this->checkpoint) {
+      this->checkpoint->finish();
+    }
+    if (this->trace.enabled()) {
+      this->trace.write(this->options.trace_path);
+    }
+    calculation_results results = {0, this->stat_iteration, this->stat_accuracy, this->start_time, end_time};
+    if (this->counters) {
+      results.perf_samples = {this->counters->stop()};
+      results.perf_error = this->counters->error().value_or("");
+    }
+    return results;
+  }
+
+  template void iteration_loop::end_iteration(const basic_tensor<double> &, double);
+  template void iteration_loop::end_iteration(const basic_tensor<float> &, double);
+
+} // namespace partdiff
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "calculation_arguments.hpp"
+#include "calculation_options.hpp"
+#include "calculation_results.hpp"
+#include "checkpoint.hpp"
+#include "perf_counters.hpp"
+#include "tensor.hpp"
+#include "trace.hpp"
+#include <cstdint>
+#include <optional>
+
+namespace partdiff {
+
+  // The bookkeeping around the iterations of the single-threaded solvers, multigrid and conjugate gradient: the
+  // iteration count, the termination condition, the trace, the checkpoints, the hardware counters and the caller's
+  // solve_control. A solver runs
+  //   while (loop.running()) { loop.begin_iteration(); ...; loop.end_iteration(matrices, residuum); }
+  // and returns loop.finish().
+  class iteration_loop {
+    public:
+    iteration_loop(calculation_arguments &arguments, const calculation_options &options,
+                   calculation_results::time_point start_time);
+    bool running() const {
+      return this->term_iteration > 0;
+    }
+    uint64_t iteration() const {
+      return this->stat_iteration;
+    }
+    void begin_iteration();
+    // Counts an iteration whose largest change was residuum. The solution is matrix 0 of matrices.
+    template <typename T>
+    void end_iteration(const basic_tensor<T> &matrices, double residuum);
+    // Replaces the residuum of the last iteration, e.g. by one recomputed from the solution.
+    void set_accuracy(double residuum) {
+      this->stat_accuracy = residuum;
+    }
+    // Writes the trace and returns the results, with the end time of the calculation and the counts of --perf.
+    calculation_results finish();
+
+    private:
+    const calculation_options &options;
+    solve_control *const control;
+    const int N;
+    calculation_results::time_point start_time;
+    uint64_t stat_iteration;
+    double stat_accuracy;
+    int term_iteration;
+    trace_buffer trace;
+    bool traced = false;
+    calculation_results::time_point iteration_begin;
+    std::optional<checkpoint_writer> checkpoint;
+    uint64_t next_checkpoint;
+    std::optional<perf_counters> counters;
+  };
+
+} // namespace partdiff
@@ -0,0 +1,394 @@
+#include "kernels.hpp"
+#include "failure.hpp"
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <type_traits>
+#include <utility>
+
+#if defined(__x86_64__)
+  #include <immintrin.h>
+#endif
+
+namespace partdiff {
+
+  namespace {
+
+    // The scalar kernels load elements of the storage type T and do their arithmetic in the type C. With T = C =
+    // double, they perform exactly the operations of the reference implementation.
+
+    // Jacobi reads from one matrix and writes to the other, so the rows never alias and the loop can be vectorized.
+    template <typename T, typename C, perturbation_function pert_func, bool compute_residuum>
+    [[gnu::always_inline]] inline C jacobi_row(T *__restrict__ out, const T *__restrict__ above,
+                                                const T *__restrict__ centre, const T *__restrict__ below,
+                                                const double *__restrict__ col_factors, const C fpisin_i,
+                                                const int j_begin, const int j_end) {
+      C maxresiduum = 0.0;
+
+      for (int j = j_begin; j < j_end; j++) {
+        C star = C(0.25) * (C(above[j]) + C(centre[j - 1]) + C(centre[j + 1]) + C(below[j]));
+
+        if constexpr (pert_func == perturbation_function::fpisin) {
+          star += fpisin_i * C(col_factors[j]);
+        }
+
+        if constexpr (compute_residuum) {
+          C residuum = C(centre[j]) - star;
+          residuum = std::fabs(residuum);
+          maxresiduum = std::max(residuum, maxresiduum);
+        }
+
+        out[j] = T(star);
+      }
+
+      return maxresiduum;
+    }
+
+    // Gauß-Seidel updates the row in place (step 1). Red-black Gauß-Seidel only touches every other point (step 2),
+    // whose neighbours all belong to the other colour. SOR (relaxed) moves each point omega times as far as
+    // Gauß-Seidel would. The residuum is the Gauß-Seidel one in either case, so that the accuracy means the same.
+    template <typename T, typename C, perturbation_function pert_func, bool compute_residuum, int step, bool relaxed>
+    [[gnu::always_inline]] inline C in_place_row(T *centre, const T *above, const T *below, const double *col_factors,
+                                                 const C fpisin_i, [[maybe_unused]] const C omega, const int j_begin,
+                                                 const int j_end) {
+      C maxresiduum = 0.0;
+
+      for (int j = j_begin; j < j_end; j += step) {
+        C star = C(0.25) * (C(above[j]) + C(centre[j - 1]) + C(centre[j + 1]) + C(below[j]));
+
+        if constexpr (pert_func == perturbation_function::fpisin) {
+          star += fpisin_i * C(col_factors[j]);
+        }
+
+        if constexpr (compute_residuum) {
+          C residuum = C(centre[j]) - star;
+          residuum = std::fabs(residuum);
+          maxresiduum = std::max(residuum, maxresiduum);
+        }
+
+        if constexpr (relaxed) {
+          centre[j] = T(C(centre[j]) + omega * (star - C(centre[j])));
+        } else {
+          centre[j] = T(star);
+        }
+      }
+
+      return maxresiduum;
+    }
+
+#if defined(__x86_64__)
+
+    // The vectorized Jacobi rows perform exactly the same operations in the same order as jacobi_row (for double), only
+    // on several columns at once, so they produce bit-identical results. The columns that don't fill a whole vector
+    // are handled by jacobi_row. They are compiled for their instruction set regardless of -march and are only called
+    // after resolve_simd_kernel has checked that the CPU supports it.
+
+    template <perturbation_function pert_func, bool compute_residuum>
+    [[gnu::target("avx2")]] double jacobi_row_avx2(double *__restrict__ out, const double *__restrict__ above,
+                                                   const double *__restrict__ centre, const double *__restrict__ below,
+                                                   const double *__restrict__ col_factors, const double fpisin_i,
+                                                   const int j_begin, const int j_end) {
+      constexpr int width = 4;
+      const __m256d quarter = _mm256_set1_pd(0.25);
+      const __m256d fpisin_i_v = _mm256_set1_pd(fpisin_i);
+      const __m256d sign_mask = _mm256_set1_pd(-0.0);
+      __m256d maxresiduum_v = _mm256_setzero_pd();
+
+      int j = j_begin;
+      for (; j + width <= j_end; j += width) {
+        __m256d star = _mm256_add_pd(_mm256_loadu_pd(&above[j]), _mm256_loadu_pd(&centre[j - 1]));
+        star = _mm256_add_pd(star, _mm256_loadu_pd(&centre[j + 1]));
+        star = _mm256_add_pd(star, _mm256_loadu_pd(&below[j]));
+        star = _mm256_mul_pd(quarter, star);
+
+        if constexpr (pert_func == perturbation_function::fpisin) {
+          star = _mm256_add_pd(star, _mm256_mul_pd(fpisin_i_v, _mm256_loadu_pd(&col_factors[j])));
+        }
+
+        if constexpr (compute_residuum) {
+          const __m256d residuum = _mm256_andnot_pd(sign_mask, _mm256_sub_pd(_mm256_loadu_pd(&centre[j]), star));
+          maxresiduum_v = _mm256_max_pd(residuum, maxresiduum_v);
+        }
+
+        _mm256_storeu_pd(&out[j], star);
+      }
+
+      double maxresiduum =
+          jacobi_row<double, double, pert_func, compute_residuum>(out, above, centre, below, col_factors, fpisin_i, j,
+                                                                  j_end);
+
+      if constexpr (compute_residuum) {
+        alignas(32) double lanes[width];
+        _mm256_store_pd(lanes, maxresiduum_v);
+        for (const double lane : lanes) {
+          maxresiduum = std::max(lane, maxresiduum);
+        }
+      }
+
+      return maxresiduum;
+    }
+
+    template <perturbation_function pert_func, bool compute_residuum>
+    [[gnu::target("avx512f")]] double jacobi_row_avx512(double *__restrict__ out, const double *__restrict__ above,
+                                                        const double *__restrict__ centre,
+                                                        const double *__restrict__ below,
+                                                        const double *__restrict__ col_factors, const double fpisin_i,
+                                                        const int j_begin, const int j_end) {
+      constexpr int width = 8;
+      const __m512d quarter = _mm512_set1_pd(0.25);
+      const __m512d fpisin_i_v = _mm512_set1_pd(fpisin_i);
+      __m512d maxresiduum_v = _mm512_setzero_pd();
+
+      int j = j_begin;
+      for (; j + width <= j_end; j += width) {
+        __m512d star = _mm512_add_pd(_mm512_loadu_pd(&above[j]), _mm512_loadu_pd(&centre[j - 1]));
+        star = _mm512_add_pd(star, _mm512_loadu_pd(&centre[j + 1]));
+        star = _mm512_add_pd(star, _mm512_loadu_pd(&below[j]));
+        star = _mm512_mul_pd(quarter, star);
+
+        if constexpr (pert_func == perturbation_function::fpisin) {
+          star = _mm512_add_pd(star, _mm512_mul_pd(fpisin_i_v, _mm512_loadu_pd(&col_factors[j])));
+        }
+
+        if constexpr (compute_residuum) {
+          const __m512d residuum = _mm512_abs_pd(_mm512_sub_pd(_mm512_loadu_pd(&centre[j]), star));
+          // The masked form with all lanes set is the same as _mm512_max_pd, but the latter trips GCC 12's
+          // -Wmaybe-uninitialized inside the intrinsics header.
+          maxresiduum_v = _mm512_mask_max_pd(maxresiduum_v, 0xff, residuum, maxresiduum_v);
+        }
+
+        _mm512_storeu_pd(&out[j], star);
+      }
+
+      double maxresiduum =
+          jacobi_row<double, double, pert_func, compute_residuum>(out, above, centre, below, col_factors, fpisin_i, j,
+                                                                  j_end);
+
+      if constexpr (compute_residuum) {
+        alignas(64) double lanes[width];
+        _mm512_store_pd(lanes, maxresiduum_v);
+        for (const double lane : lanes) {
+          maxresiduum = std::max(lane, maxresiduum);
+        }
+      }
+
+      return maxresiduum;
+    }
+
+#endif
+
+    // One Jacobi row with the requested SIMD kernel.
+    template <typename T, typename C, perturbation_function pert_func, bool compute_residuum, simd_kernel simd>
+    [[gnu::always_inline]] inline C jacobi_row_simd(T *out, const T *above, const T *centre, const T *below,
+                                                     const double *col_factors, const C fpisin_i, const int j_begin,
+                                                     const int j_end) {
+#if defined(__x86_64__)
+      if constexpr (simd == simd_kernel::avx2) {
+        return jacobi_row_avx2<pert_func, compute_residuum>(out, above, centre, below, col_factors, fpisin_i, j_begin,
+                                                            j_end);
+      } else if constexpr (simd == simd_kernel::avx512) {
+        return jacobi_row_avx512<pert_func, compute_residuum>(out, above, centre, below, col_factors, fpisin_i,
+                                                              j_begin, j_end);
+      }
+#endif
+      return jacobi_row<T, C, pert_func, compute_residuum>(out, above, centre, below, col_factors, fpisin_i, j_begin,
+                                                           j_end);
+    }
+
+    template <typename T, typename C, perturbation_function pert_func, bool compute_residuum, simd_kernel simd>
+    double jacobi_row_kernel(T *out, const T *above, const T *centre, const T *below, const int i, const int j_begin,
+                             const int j_end, const perturbation_source &perturbation) {
+      C fpisin_i = 0.0;
+
+      if constexpr (pert_func == perturbation_function::fpisin) {
+        fpisin_i = C(perturbation.row_factors[i]);
+      }
+
+      return jacobi_row_simd<T, C, pert_func, compute_residuum, simd>(out, above, centre, below,
+                                                                      perturbation.col_factors.data(), fpisin_i,
+                                                                      j_begin, j_end);
+    }
+
+    template <typename T, typename C, calculation_method method, perturbation_function pert_func, bool compute_residuum,
+              int colour, simd_kernel simd>
+    double sweep(basic_tensor<T> &matrices, const int m1, const int m2, const sweep_range &range,
+                 const perturbation_source &perturbation, const double omega) {
+      C maxresiduum = 0.0;
+
+      const double *col_factors = perturbation.col_factors.data();
+
+      for (int i = range.i_begin; i < range.i_end; i++) {
+        C fpisin_i = 0.0;
+
+        if constexpr (pert_func == perturbation_function::fpisin) {
+          fpisin_i = C(perturbation.row_factors[i]);
+        }
+
+        C row_maxresiduum;
+
+        if constexpr (method == calculation_method::jacobi) {
+          row_maxresiduum = jacobi_row_simd<T, C, pert_func, compute_residuum, simd>(
+              matrices.row(m1, i), matrices.row(m2, i - 1), matrices.row(m2, i), matrices.row(m2, i + 1), col_factors,
+              fpisin_i, range.j_begin, range.j_end);
+        } else if constexpr (method == calculation_method::gauss_seidel || method == calculation_method::sor) {
+          row_maxresiduum = in_place_row<T, C, pert_func, compute_residuum, 1, method == calculation_method::sor>(
+              matrices.row(m1, i), matrices.row(m1, i - 1), matrices.row(m1, i + 1), col_factors, fpisin_i, C(omega),
+              range.j_begin, range.j_end);
+        } else {
+          // The first column in the range with (i + j) % 2 == colour
+          const int j_begin = range.j_begin + ((i + range.j_begin + colour) & 1);
+          row_maxresiduum = in_place_row<T, C, pert_func, compute_residuum, 2, false>(
+              matrices.row(m1, i), matrices.row(m1, i - 1), matrices.row(m1, i + 1), col_factors, fpisin_i, C(omega),
+              j_begin, range.j_end);
+        }
+
+        if constexpr (compute_residuum) {
+          maxresiduum = std::max(row_maxresiduum, maxresiduum);
+        }
+      }
+
+      return maxresiduum;
+    }
+
+    template <typename T, typename C, calculation_method method, perturbation_function pert_func, bool compute_residuum>
+    sweep_kernel<T> select_kernel(const int colour, [[maybe_unused]] const simd_kernel simd) {
+      if constexpr (method == calculation_method::jacobi) {
+#if defined(__x86_64__)
+        // The vectorized kernels only exist for double, float relies on the compiler's auto-vectorization.
+        if constexpr (std::is_same_v<T, double> && std::is_same_v<C, double>) {
+          if (simd == simd_kernel::avx512) {
+            return sweep<T, C, method, pert_func, compute_residuum, 0, simd_kernel::avx512>;
+          }
+          if (simd == simd_kernel::avx2) {
+            return sweep<T, C, method, pert_func, compute_residuum, 0, simd_kernel::avx2>;
+          }
+        }
+#endif
+        return sweep<T, C, method, pert_func, compute_residuum, 0, simd_kernel::scalar>;
+      }
+      if (colour == 0) {
+        return sweep<T, C, method, pert_func, compute_residuum, 0, simd_kernel::scalar>;
+      }
+      return sweep<T, C, method, pert_func, compute_residuum, 1, simd_kernel::scalar>;
+    }
+
+    template <typename T, typename C, calculation_method method>
+    sweep_kernel<T> select_kernel(const perturbation_function pert_func, const bool compute_residuum, const int colour,
+                                  const simd_kernel simd) {
+      if (pert_func == perturbation_function::fpisin) {
+        return compute_residuum ? select_kernel<T, C, method, perturbation_function::fpisin, true>(colour, simd)
+                                : select_kernel<T, C, method, perturbation_function::fpisin, false>(colour, simd);
+      }
+      return compute_residuum ? select_kernel<T, C, method, perturbation_function::f0, true>(colour, simd)
+                              : select_kernel<T, C, method, perturbation_function::f0, false>(colour, simd);
+    }
+
+    template <typename T, typename C>
+    sweep_kernel<T> select_kernel(const calculation_method method, const perturbation_function pert_func,
+                                  const bool compute_residuum, const int colour, const simd_kernel simd) {
+      switch (method) {
+      case calculation_method::gauss_seidel:
+        return select_kernel<T, C, calculation_method::gauss_seidel>(pert_func, compute_residuum, 0, simd);
+      case calculation_method::sor:
+        return select_kernel<T, C, calculation_method::sor>(pert_func, compute_residuum, 0, simd);
+      case calculation_method::jacobi:
+        return select_kernel<T, C, calculation_method::jacobi>(pert_func, compute_residuum, 0, simd);
+      case calculation_method::red_black:
+      case calculation_method::multigrid:
+        return select_kernel<T, C, calculation_method::red_black>(pert_func, compute_residuum, colour, simd);
+      case calculation_method::conjugate_gradient:
+        // CG applies the stencil itself and has no sweeps.
+        break;
+      }
+      return nullptr;
+    }
+
+    template <typename T, typename C, perturbation_function pert_func, bool compute_residuum>
+    jacobi_row_kernel_t<T> select_jacobi_row([[maybe_unused]] const simd_kernel simd) {
+#if defined(__x86_64__)
+      if constexpr (std::is_same_v<T, double> && std::is_same_v<C, double>) {
+        if (simd == simd_kernel::avx512) {
+          return jacobi_row_kernel<T, C, pert_func, compute_residuum, simd_kernel::avx512>;
+        }
+        if (simd == simd_kernel::avx2) {
+          return jacobi_row_kernel<T, C, pert_func, compute_residuum, simd_kernel::avx2>;
+        }
+      }
+#endif
+      return jacobi_row_kernel<T, C, pert_func, compute_residuum, simd_kernel::scalar>;
+    }
+
+    template <typename T, typename C>
+    jacobi_row_kernel_t<T> select_jacobi_row(const perturbation_function pert_func, const bool compute_residuum,
+                                             const simd_kernel simd) {
+      if (pert_func == perturbation_function::fpisin) {
+        return compute_residuum ? select_jacobi_row<T, C, perturbation_function::fpisin, true>(simd)
+                                : select_jacobi_row<T, C, perturbation_function::fpisin, false>(simd);
+      }
+      return compute_residuum ? select_jacobi_row<T, C, perturbation_function::f0, true>(simd)
+                              : select_jacobi_row<T, C, perturbation_function::f0, false>(simd);
+    }
+
+  } // namespace
+
+  simd_kernel resolve_simd_kernel(const simd_kernel requested) {
+    bool avx2 = false;
+    bool avx512 = false;
+#if defined(__x86_64__)
+    avx2 = __builtin_cpu_supports("avx2");
+    avx512 = __builtin_cpu_supports("avx512f");
+#endif
+    switch (requested) {
+    case simd_kernel::automatic:
+      return avx512 ? simd_kernel::avx512 : (avx2 ? simd_kernel::avx2 : simd_kernel::scalar);
+    case simd_kernel::scalar:
+      return simd_kernel::scalar;
+    case simd_kernel::avx2:
+      if (avx2) {
+        return simd_kernel::avx2;
+      }
+      break;
+    case simd_kernel::avx512:
+      if (avx512) {
+        return simd_kernel::avx512;
+      }
+      break;
+    }
+    fail(std::format("The {:s} kernel is not supported on this CPU!", requested));
+  }
+
+  template <>
+  sweep_kernel<double> select_kernel<double>(const calculation_method method, const perturbation_function pert_func,
+                                             const bool compute_residuum, const int colour, const simd_kernel simd,
+                                             [[maybe_unused]] const storage_precision precision) {
+    return select_kernel<double, double>(method, pert_func, compute_residuum, colour, simd);
+  }
+
+  template <>
+  sweep_kernel<float> select_kernel<float>(const calculation_method method, const perturbation_function pert_func,
+                                           const bool compute_residuum, const int colour, const simd_kernel simd,
+                                           const storage_precision precision) {
+    if (precision == storage_precision::mixed) {
+      return select_kernel<float, double>(method, pert_func, compute_residuum, colour, simd);
+    }
+    return select_kernel<float, float>(method, pert_func, compute_residuum, colour, simd);
+  }
+
+  template <>
+  jacobi_row_kernel_t<double> select_jacobi_row<double>(const perturbation_function pert_func,
+                                                        const bool compute_residuum, const simd_kernel simd,
+                                                        [[maybe_unused]] const storage_precision precision) {
+    return select_jacobi_row<double, double>(pert_func, compute_residuum, simd);
+  }
+
+  template <>
+  jacobi_row_kernel_t<float> select_jacobi_row<float>(const perturbation_function pert_func,
+                                                      const bool compute_residuum, const simd_kernel simd,
+                                                      const storage_precision precision) {
+    if (precision == storage_precision::mixed) {
+      return select_jacobi_row<float, double>(pert_func, compute_residuum, simd);
+    }
+    return select_jacobi_row<float, float>(pert_func, compute_residuum, simd);
+  }
+
+} // namespace partdiff
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "enums.hpp"
+#include "perturbation_source.hpp"
+#include "tensor.hpp"
+
+namespace partdiff {
+
+  // The part of the grid that a kernel sweeps: rows [i_begin, i_end) and columns [j_begin, j_end).
+  struct sweep_range {
+    int i_begin;
+    int i_end;
+    int j_begin;
+    int j_end;
+  };
+
+  // Sweeps the given range of matrix m1 using the values of matrix m2 and returns the maximum residuum (or 0.0 if the
+  // kernel does not compute it). Gauß-Seidel, red-black Gauß-Seidel and SOR work in place and only use m1. omega is
+  // the relaxation factor of SOR and ignored by the other methods.
+  template <typename T>
+  using sweep_kernel = double (*)(basic_tensor<T> &matrices, int m1, int m2, const sweep_range &range,
+                                  const perturbation_source &perturbation, double omega);
+
+  // Computes row i of a Jacobi sweep into out from the rows above, centre and below of the previous iteration, over
+  // the columns [j_begin, j_end), and returns its maximum residuum (or 0.0 if the kernel does not compute it). These
+  // are the operations of the Jacobi sweep_kernel on one row, but the rows may come from anywhere, e.g. from a buffer
+  // that holds an iteration which is never stored in the matrices.
+  template <typename T>
+  using jacobi_row_kernel_t = double (*)(T *out, const T *above, const T *centre, const T *below, int i, int j_begin,
+                                         int j_end, const perturbation_source &perturbation);
+
+  // Returns the SIMD kernel to use for the requested one: automatic picks the widest one that the CPU supports, and a
+  // forced kernel that the CPU doesn't support is an error.
+  simd_kernel resolve_simd_kernel(simd_kernel requested);
+
+  // Picks the kernel instantiation for a combination of method, perturbation function and whether the residuum is
+  // needed, so that the inner loops don't have to branch on them. For red-black Gauß-Seidel, colour selects the
+  // half-sweep (0: red, 1: black). It is ignored for the other methods. Multigrid gets the red-black kernels, which it
+  // smooths with, and conjugate gradient, which has no sweeps, gets nullptr. simd must already be resolved. Only Jacobi
+  // on doubles has vectorized kernels, everything else uses the scalar ones. T is the storage type of the tensor, and
+  // for float, precision decides whether the arithmetic is done in double (mixed) or float (single).
+  template <typename T>
+  sweep_kernel<T> select_kernel(calculation_method method, perturbation_function pert_func, bool compute_residuum,
+                                int colour, simd_kernel simd, storage_precision precision);
+
+  // Picks the Jacobi row kernel, like select_kernel does for the sweeps.
+  template <typename T>
+  jacobi_row_kernel_t<T> select_jacobi_row(perturbation_function pert_func, bool compute_residuum, simd_kernel simd,
+                                           storage_precision precision);
+
+} // namespace partdiff
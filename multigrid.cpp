@@ -0,0 +1,186 @@
+#include "multigrid.hpp"
+#include "enums.hpp"
+#include "interpolation.hpp"
+#include "iteration_loop.hpp"
+#include "kernels.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace partdiff {
+
+  namespace {
+
+    constexpr int pre_sweeps = 2;
+    constexpr int post_sweeps = 2;
+    // The coarsest grid has at most 2x2 interior points, where this many sweeps solve the system exactly.
+    constexpr int coarsest_sweeps = 32;
+
+    // A grid below the finest one. It solves for the correction of the grid above it, so its boundary is zero and its
+    // right-hand side is the residuum of the grid above. Like the sweeps, every level solves the scaled equation
+    // u[i][j] = 0.25 * (sum of the neighbours) + rhs[i][j], whose right-hand side contains h^2.
+    struct coarse_level {
+      int n;
+      tensor u;
+      tensor rhs;
+      interpolation to_fine;
+    };
+
+    // One red-black Gauß-Seidel sweep over a coarse level.
+    void smooth(coarse_level &level) {
+      for (int colour = 0; colour < 2; colour++) {
+        for (int i = 1; i < level.n; i++) {
+          double *centre = level.u.row(0, i);
+          const double *above = level.u.row(0, i - 1);
+          const double *below = level.u.row(0, i + 1);
+          const double *rhs = level.rhs.row(0, i);
+          for (int j = 1 + ((i + 1 + colour) & 1); j < level.n; j += 2) {
+            centre[j] = 0.25 * (above[j] + centre[j - 1] + centre[j + 1] + below[j]) + rhs[j];
+          }
+        }
+      }
+    }
+
+    // Computes the residuum of the grid with n intervals and restricts it to the next coarser level, whose correction
+    // starts from zero. The restriction is the transpose of the prolongation. Its weights add up to (n / coarse.n)^2,
+    // which is exactly the factor by which h^2 in the right-hand side grows, so the residuum needs no further scaling.
+    template <typename T, typename Rhs>
+    void restrict_residuum(basic_tensor<T> &u, const int n, const Rhs &rhs, coarse_level &coarse) {
+      for (int i = 0; i <= coarse.n; i++) {
+        std::fill(coarse.u.row(0, i), coarse.u.row(0, i) + coarse.n + 1, 0.0);
+        std::fill(coarse.rhs.row(0, i), coarse.rhs.row(0, i) + coarse.n + 1, 0.0);
+      }
+
+      const interpolation &ip = coarse.to_fine;
+      for (int i = 1; i < n; i++) {
+        const T *centre = u.row(0, i);
+        const T *above = u.row(0, i - 1);
+        const T *below = u.row(0, i + 1);
+        const double wi = ip.weight[i];
+        double *coarse_above = coarse.rhs.row(0, ip.index[i]);
+        double *coarse_below = coarse.rhs.row(0, ip.index[i] + 1);
+        for (int j = 1; j < n; j++) {
+          const double star =
+              0.25 * ((double)above[j] + (double)centre[j - 1] + (double)centre[j + 1] + (double)below[j]) + rhs(i, j);
+          const double r = star - (double)centre[j];
+          const int J = ip.index[j];
+          const double wj = ip.weight[j];
+          coarse_above[J] += (1.0 - wi) * (1.0 - wj) * r;
+          coarse_above[J + 1] += (1.0 - wi) * wj * r;
+          coarse_below[J] += wi * (1.0 - wj) * r;
+          coarse_below[J + 1] += wi * wj * r;
+        }
+      }
+    }
+
+    // Adds the interpolated correction of the coarse level to the interior of the grid with n intervals.
+    template <typename T>
+    void prolongate(coarse_level &coarse, basic_tensor<T> &u, const int n) {
+      const interpolation &ip = coarse.to_fine;
+      for (int i = 1; i < n; i++) {
+        T *centre = u.row(0, i);
+        const double wi = ip.weight[i];
+        const double *coarse_above = coarse.u.row(0, ip.index[i]);
+        const double *coarse_below = coarse.u.row(0, ip.index[i] + 1);
+        for (int j = 1; j < n; j++) {
+          const int J = ip.index[j];
+          const double wj = ip.weight[j];
+          const double correction = (1.0 - wi) * ((1.0 - wj) * coarse_above[J] + wj * coarse_above[J + 1]) +
+                                    wi * ((1.0 - wj) * coarse_below[J] + wj * coarse_below[J + 1]);
+          centre[j] = T((double)centre[j] + correction);
+        }
+      }
+    }
+
+    // The V-cycle below the finest grid.
+    void cycle(std::vector<coarse_level> &levels, const std::size_t l) {
+      coarse_level &level = levels[l];
+      if (l + 1 == levels.size()) {
+        for (int s = 0; s < coarsest_sweeps; s++) {
+          smooth(level);
+        }
+        return;
+      }
+      for (int s = 0; s < pre_sweeps; s++) {
+        smooth(level);
+      }
+      restrict_residuum(level.u, level.n, [&level](const int i, const int j) { return level.rhs[0, i, j]; },
+                        levels[l + 1]);
+      cycle(levels, l + 1);
+      prolongate(levels[l + 1], level.u, level.n);
+      for (int s = 0; s < post_sweeps; s++) {
+        smooth(level);
+      }
+    }
+
+    template <typename T>
+    calculation_results calculate_multigrid(basic_tensor<T> &matrices, calculation_arguments &arguments,
+                                            const calculation_options &options) {
+
+      const auto start_time = std::chrono::high_resolution_clock::now();
+
+      const int N = arguments.N;
+
+      // The grids are halved down to at most two intervals.
+      std::vector<coarse_level> levels;
+      for (int n = N; n >= 4; n /= 2) {
+        const int n_coarse = n / 2;
+        levels.push_back({n_coarse, tensor(1, n_coarse + 1, n_coarse + 1), tensor(1, n_coarse + 1, n_coarse + 1),
+                          interpolation(n, n_coarse)});
+      }
+
+      // The finest grid is smoothed with the red-black Gauß-Seidel kernels, whose right-hand side is the perturbation.
+      // Red-black only has scalar kernels, so there is no SIMD kernel to pick.
+      const perturbation_source &perturbation = arguments.perturbation;
+      const auto rhs = [&perturbation](const int i, const int j) {
+        return perturbation.enabled() ? perturbation.row_factors[i] * perturbation.col_factors[j] : 0.0;
+      };
+      const sweep_range range = {1, N, 1, N};
+      std::array<sweep_kernel<T>, 2> kernels;
+      std::array<sweep_kernel<T>, 2> residuum_kernels;
+      for (int colour = 0; colour < 2; colour++) {
+        kernels[colour] = select_kernel<T>(calculation_method::red_black, options.pert_func, false, colour,
+                                           simd_kernel::scalar, options.precision);
+        residuum_kernels[colour] = select_kernel<T>(calculation_method::red_black, options.pert_func, true, colour,
+                                                    simd_kernel::scalar, options.precision);
+      }
+
+      iteration_loop loop(arguments, options, start_time);
+
+      while (loop.running()) {
+        loop.begin_iteration();
+
+        for (int s = 0; s < pre_sweeps; s++) {
+          kernels[0](matrices, 0, 0, range, perturbation, 1.0);
+          kernels[1](matrices, 0, 0, range, perturbation, 1.0);
+        }
+
+        restrict_residuum(matrices, N, rhs, levels[0]);
+        cycle(levels, 0);
+        prolongate(levels[0], matrices, N);
+
+        for (int s = 1; s < post_sweeps; s++) {
+          kernels[0](matrices, 0, 0, range, perturbation, 1.0);
+          kernels[1](matrices, 0, 0, range, perturbation, 1.0);
+        }
+        const double red_maxresiduum = residuum_kernels[0](matrices, 0, 0, range, perturbation, 1.0);
+        const double black_maxresiduum = residuum_kernels[1](matrices, 0, 0, range, perturbation, 1.0);
+        const double maxresiduum = std::max(red_maxresiduum, black_maxresiduum);
+
+        loop.end_iteration(matrices, maxresiduum);
+      }
+
+      return loop.finish();
+    }
+
+  } // namespace
+
+  calculation_results calculate_multigrid(calculation_arguments &arguments, const calculation_options &options) {
+    if (options.precision == storage_precision::double_precision) {
+      return calculate_multigrid(arguments.matrices, arguments, options);
+    }
+    return calculate_multigrid(arguments.matrices_float, arguments, options);
+  }
+
+} // namespace partdiff
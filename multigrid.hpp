@@ -0,0 +1,13 @@
+#pragma once
+
+#include "calculation_arguments.hpp"
+#include "calculation_options.hpp"
+#include "calculation_results.hpp"
+
+namespace partdiff {
+
+  // Solves the system with multigrid V-cycles. One cycle counts as one iteration, and the residuum is that of the last
+  // red-black sweep on the finest grid, just as for red-black Gauß-Seidel.
+  calculation_results calculate_multigrid(calculation_arguments &arguments, const calculation_options &options);
+
+} // namespace partdiff
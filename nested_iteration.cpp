@@ -0,0 +1,80 @@
+#include "nested_iteration.hpp"
+#include "calculation.hpp"
+#include "interpolation.hpp"
+#include <thread>
+#include <vector>
+
+namespace partdiff {
+
+  namespace {
+
+    // Interpolates matrix m of the coarse grid into the interior of all matrices of the fine grid. Every thread fills
+    // the band of rows that it sweeps.
+    template <typename T>
+    void interpolate(const calculation_arguments &coarse, const int m, calculation_arguments &fine,
+                     basic_tensor<T> &matrices) {
+      const int n_fine = fine.N;
+      const int n_coarse = coarse.N;
+      const interpolation ip(n_fine, n_coarse);
+      const auto interpolate_band = [&](const int thread_id) {
+        const auto [first, last] = fine.row_band(thread_id);
+        std::vector<double> above(n_coarse + 1);
+        std::vector<double> below(n_coarse + 1);
+        for (int i = first; i < last; i++) {
+          const int I = ip.index[i];
+          const double wi = ip.weight[i];
+          for (int J = 0; J <= n_coarse; J++) {
+            above[J] = coarse.value(m, I, J);
+            below[J] = coarse.value(m, I + 1, J);
+          }
+          for (uint64_t g = 0; g < fine.num_matrices; g++) {
+            T *row = matrices.row(g, i);
+            for (int j = 1; j < n_fine; j++) {
+              const int J = ip.index[j];
+              const double wj = ip.weight[j];
+              row[j] = T((1.0 - wi) * ((1.0 - wj) * above[J] + wj * above[J + 1]) +
+                         wi * ((1.0 - wj) * below[J] + wj * below[J + 1]));
+            }
+          }
+        }
+      };
+
+      std::vector<std::jthread> threads;
+      for (uint64_t t = 1; t < fine.num_threads; t++) {
+        threads.emplace_back(interpolate_band, t);
+      }
+      interpolate_band(0);
+    }
+
+  } // namespace
+
+  bool warm_start_enabled(const calculation_arguments &arguments, const calculation_options &options) {
+    return options.nested && options.termination == termination_condition::accuracy && options.interlines > 0 &&
+           arguments.initial_iteration == 0;
+  }
+
+  void warm_start(calculation_arguments &arguments, const calculation_options &options) {
+    // The coarse grids only serve as the initial guess, so they neither write nor record anything.
+    calculation_options coarse_options = options;
+    coarse_options.interlines = (options.interlines - 1) / 2;
+    coarse_options.checkpoint_path = "";
+    coarse_options.resume_path = "";
+    coarse_options.trace_path = "";
+    coarse_options.perf = false;
+    coarse_options.field_path = "";
+
+    // They report to the caller's solve_control as well, so that it can cancel them.
+    calculation_arguments coarse(coarse_options);
+    coarse.control = arguments.control;
+    const calculation_results results = calculate(coarse, coarse_options);
+    if (arguments.control && arguments.control->cancelled()) {
+      return;
+    }
+    if (options.precision == storage_precision::double_precision) {
+      interpolate(coarse, results.m, arguments, arguments.matrices);
+    } else {
+      interpolate(coarse, results.m, arguments, arguments.matrices_float);
+    }
+  }
+
+} // namespace partdiff
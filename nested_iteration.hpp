@@ -0,0 +1,19 @@
+#pragma once
+
+#include "calculation_arguments.hpp"
+#include "calculation_options.hpp"
+
+namespace partdiff {
+
+  // Whether calculate() starts from the interpolated solution of a coarser grid instead of zero: with --nested, in
+  // accuracy mode, on a fresh start with more than 0 interlines.
+  bool warm_start_enabled(const calculation_arguments &arguments, const calculation_options &options);
+
+  // Replaces the zero interior of the matrices with the solution of the next coarser grid, which has (interlines - 1)
+  // / 2 interlines and so about half the intervals, interpolated bilinearly. The coarser grid is solved to the same
+  // accuracy with the same method and is warm started in turn, down to 0 interlines. Most sweeps on a fine grid only
+  // carry the boundary values into the interior, which the coarse solution already did at a fraction of the cost, so
+  // the fine grid only has to remove the interpolation error.
+  void warm_start(calculation_arguments &arguments, const calculation_options &options);
+
+} // namespace partdiff
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "argument_parser.hpp"
+#include "enums.hpp"
+#include <cstdint>
+
+namespace partdiff {
+
+  // The values that partdiff accepts for the options, which solve_async() enforces as well.
+  inline constexpr bounds_t<uint64_t> num_bounds{1, 1024};
+  inline constexpr bounds_t<calculation_method> method_bounds{calculation_method::gauss_seidel,
+                                                              calculation_method::sor};
+  inline constexpr bounds_t<uint64_t> lines_bounds{0, 10240};
+  inline constexpr bounds_t<perturbation_function> func_bounds{perturbation_function::f0,
+                                                               perturbation_function::fpisin};
+  inline constexpr bounds_t<termination_condition> term_bounds{termination_condition::accuracy,
+                                                               termination_condition::iterations};
+  inline constexpr bounds_t<double> term_accuracy_bounds{1e-20, 1e-4};
+  inline constexpr bounds_t<uint64_t> term_iteration_bounds{1, 200000};
+  inline constexpr bounds_t<simd_kernel> kernel_bounds{simd_kernel::automatic, simd_kernel::avx512};
+  inline constexpr bounds_t<uint64_t> tile_depth_bounds{0, 64};
+  inline constexpr bounds_t<storage_precision> precision_bounds{storage_precision::double_precision,
+                                                                storage_precision::single_precision};
+  inline constexpr bounds_t<double> omega_bounds{0.0, 1.99};
+  inline constexpr bounds_t<uint64_t> checkpoint_every_bounds{1, 200000};
+  inline constexpr bounds_t<uint64_t> check_every_bounds{1, 1000};
+  inline constexpr bounds_t<uint64_t> trace_every_bounds{1, 200000};
+  inline constexpr bounds_t<uint64_t> trace_size_bounds{1, 1 << 24};
+
+} // namespace partdiff
@@ -1,123 +1,121 @@
 #include "argument_parser.hpp"
+#include "calculation.hpp"
 #include "calculation_arguments.hpp"
 #include "calculation_options.hpp"
 #include "calculation_results.hpp"
+#include "checkpoint.hpp"
 #include "enums.hpp"
-#include <cmath>
+#include "failure.hpp"
+#include "field_output.hpp"
+#include "option_bounds.hpp"
+#include "perf_counters.hpp"
+#include "tensor_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
 #include <format>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <optional>
 #include <print>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
-namespace partdiff {
-
-  static constexpr double pi = std::numbers::pi;
-  static constexpr double two_pi_square = (2 * pi * pi);
-
-  static calculation_results calculate(calculation_arguments &arguments, const calculation_options &options) {
-
-    const auto now = std::chrono::high_resolution_clock::now;
-
-    const auto start_time = now();
-
-    uint64_t stat_iteration = 0;
-    double stat_accuracy = 0.0;
+#if defined(PARTDIFF_MPI)
+  #include "calculation_mpi.hpp"
+  #include <mpi.h>
+#endif
 
-    const int N = arguments.N;
-    const double h = arguments.h;
-
-    double pih = 0.0;
-    double fpisin = 0.0;
-
-    int term_iteration = options.term_iteration;
-
-    int m1 = 0;
-    int m2 = (options.method == calculation_method::jacobi) ? 1 : 0;
+namespace partdiff {
 
-    if (options.pert_func == perturbation_function::fpisin) {
-      pih = pi * h;
-      fpisin = 0.25 * two_pi_square * h * h;
+  // The hardware counters of all threads, the IPC and the memory traffic per update of a grid point, which is
+  // estimated from the LLC misses with one cache line per miss. With several threads, the counters of every thread
+  // follow.
+  static void display_perf(const calculation_arguments &arguments, const calculation_results &results,
+                           std::FILE *out) {
+    if (results.perf_samples.empty() || !results.perf_error.empty()) {
+      std::println(out, "Hardware counters:      not available ({})", results.perf_error);
+      return;
     }
 
-    double maxresiduum = 0.0;
-
-    while (term_iteration > 0) {
-
-      maxresiduum = 0.0;
-
-      for (int i = 1; i < N; i++) {
-        double fpisin_i = 0.0;
-
-        if (options.pert_func == perturbation_function::fpisin) {
-          fpisin_i = fpisin * std::sin(pih * (double)i);
-        }
-
-        for (int j = 1; j < N; j++) {
-          double star = 0.25 * (arguments.matrices[m2, i - 1, j] + arguments.matrices[m2, i, j - 1] +
-                                arguments.matrices[m2, i, j + 1] + arguments.matrices[m2, i + 1, j]);
-
-          if (options.pert_func == perturbation_function::fpisin) {
-            star += fpisin_i * std::sin(pih * (double)j);
-          }
-
-          if (options.termination == termination_condition::accuracy || term_iteration == 1) {
-            double residuum = arguments.matrices[m2, i, j] - star;
-            residuum = std::fabs(residuum);
-            maxresiduum = std::max(residuum, maxresiduum);
-          }
-
-          arguments.matrices[m1, i, j] = star;
-        }
-      }
-
-      stat_iteration++;
-      stat_accuracy = maxresiduum;
-
-      const int temp = m1;
-      m1 = m2;
-      m2 = temp;
+    const auto count = [](const std::optional<uint64_t> value) {
+      return value ? std::format("{:e}", (double)*value) : std::string("n/a");
+    };
+    const auto ipc = [](const perf_sample &sample) {
+      const auto cycles = sample[perf_event::cycles];
+      const auto instructions = sample[perf_event::instructions];
+      return (cycles && instructions && *cycles > 0) ? std::format("{:.2f}", (double)*instructions / *cycles)
+                                                     : std::string("n/a");
+    };
 
-      if (options.termination == termination_condition::accuracy) {
-        if (maxresiduum < options.term_accuracy) {
-          term_iteration = 0;
-        }
-      } else if (options.termination == termination_condition::iterations) {
-        term_iteration--;
+    perf_sample total = results.perf_samples[0];
+    for (std::size_t t = 1; t < results.perf_samples.size(); t++) {
+      total += results.perf_samples[t];
+    }
+    const double updates = (double)(arguments.N - 1) * (double)(arguments.N - 1) *
+                           (double)(results.stat_iteration - arguments.initial_iteration);
+    const auto llc_misses = total[perf_event::llc_misses];
+    const std::string bytes_per_update = (llc_misses && updates > 0)
+                                             ? std::format("{:.3f}", 64.0 * (double)*llc_misses / updates)
+                                             : std::string("n/a");
+
+    std::println(out, "Cycles:                 {}", count(total[perf_event::cycles]));
+    std::println(out, "Instructions:           {}", count(total[perf_event::instructions]));
+    std::println(out, "IPC:                    {}", ipc(total));
+    std::println(out, "L1D load misses:        {}", count(total[perf_event::l1d_misses]));
+    std::println(out, "LLC misses:             {}", count(total[perf_event::llc_misses]));
+    std::println(out, "Backend stall cycles:   {}", count(total[perf_event::backend_stalls]));
+    std::println(out, "Bytes per update:       {}", bytes_per_update);
+    if (results.perf_samples.size() > 1) {
+      for (std::size_t t = 0; t < results.perf_samples.size(); t++) {
+        const perf_sample &sample = results.perf_samples[t];
+        std::println(out, "{:24}IPC {}, cycles {}, L1D load misses {}, LLC misses {}, backend stalls {}",
+                     std::format("Thread {}:", t), ipc(sample), count(sample[perf_event::cycles]),
+                     count(sample[perf_event::l1d_misses]), count(sample[perf_event::llc_misses]),
+                     count(sample[perf_event::backend_stalls]));
       }
     }
-
-    const auto end_time = now();
-
-    calculation_results results = {m2, stat_iteration, stat_accuracy, start_time, end_time};
-    return results;
   }
 
   static void display_statistics(const calculation_arguments &arguments, const calculation_results &results,
-                                 const calculation_options &options) {
+                                 const calculation_options &options, std::FILE *out = stdout) {
 
     const int N = arguments.N;
     const double time = std::chrono::duration<double>(results.end_time - results.start_time).count();
-    const double memory_consumption = (N + 1) * (N + 1) * sizeof(double) * arguments.num_matrices / 1024.0 / 1024.0;
-
-    std::println("Calculation time:       {:0.6f} s", time);
-    std::println("Memory usage:           {:0.6f} MiB", memory_consumption);
-    std::println("Calculation method:     {:s}", options.method);
-    std::println("Interlines:             {:d}", options.interlines);
-    std::println("Perturbation function:  {:s}", options.pert_func);
-    std::println("Termination:            {:s}", options.termination);
-    std::println("Number of iterations:   {:d}", results.stat_iteration);
-    std::println("Residuum:               {:e}", results.stat_accuracy);
+    const double memory_consumption =
+        (N + 1) * (N + 1) * arguments.element_size * arguments.num_matrices / 1024.0 / 1024.0;
+
+    std::println(out, "Calculation time:       {:0.6f} s", time);
+    if (options.setup_time) {
+      std::println(out, "Setup time:             {:0.6f} s", arguments.setup_seconds);
+    }
+    std::println(out, "Memory usage:           {:0.6f} MiB", memory_consumption);
+    std::println(out, "Calculation method:     {:s}", options.method);
+    std::println(out, "Interlines:             {:d}", options.interlines);
+    std::println(out, "Perturbation function:  {:s}", options.pert_func);
+    std::println(out, "Termination:            {:s}", options.termination);
+    std::println(out, "Number of iterations:   {:d}", results.stat_iteration);
+    std::println(out, "Residuum:               {:e}", results.stat_accuracy);
+
+    if (options.perf) {
+      display_perf(arguments, results, out);
+    }
   }
 
-  static void display_matrix(const calculation_arguments &arguments, const calculation_results &results,
-                             const calculation_options &options) {
-    std::println("");
-    std::println("Matrix:");
+  static void display_matrix(const matrix_sample &sample, std::FILE *out = stdout) {
+    std::println(out, "");
+    std::println(out, "Matrix:");
 
     for (int y = 0; y < 9; y++) {
       for (int x = 0; x < 9; x++) {
-        std::print(" {:.4f}",
-                   arguments.matrices[results.m, y * (options.interlines + 1), x * (options.interlines + 1)]);
+        std::print(out, " {:.4f}", sample[y][x]);
       }
-      std::println("");
+      std::println(out, "");
     }
   }
 
@@ -126,10 +124,10 @@ namespace partdiff {
     return static_cast<U>(v);
   }
 
-  static calculation_options parse_args(const int argc, char const *argv[]) {
+  // Prints the usage and returns nothing if the arguments are invalid.
+  static std::optional<calculation_options> parse_options(const std::string &app_name,
+                                                          const std::vector<std::string> &args) {
 
-    const std::string app_name = argv[0];
-    const std::vector<std::string> args(argv + 1, argv + argc);
     argument_parser parser(app_name, std::format("Example: {} 1 2 100 1 2 100", app_name));
 
     constexpr int indent_width = 17;
@@ -149,37 +147,26 @@ namespace partdiff {
     };
 
     uint64_t number;
-    static constexpr bounds_t<uint64_t> num_bounds{1, 1024};
     parser.add_arg("num", number, std::make_optional(num_bounds), std::format("number of threads ({:d})", num_bounds));
 
     calculation_method method;
-    static constexpr bounds_t<calculation_method> method_bounds{calculation_method::gauss_seidel,
-                                                                calculation_method::jacobi};
     parser.add_arg("method", method, std::make_optional(method_bounds),
                    std::format("calculation method ({:d})\n{}", method_bounds, display_enum(method_bounds)));
 
     uint64_t lines;
-    static constexpr bounds_t<uint64_t> lines_bounds{0, 10240};
     parser.add_arg("lines", lines, std::make_optional(lines_bounds),
                    std::format("number of interlines ({1:d})\n"
                                "{0}matrixsize = (interlines * 8) + 9",
                                indent, lines_bounds));
 
     perturbation_function func;
-    static constexpr bounds_t<perturbation_function> func_bounds{perturbation_function::f0,
-                                                                 perturbation_function::fpisin};
     parser.add_arg("func", func, std::make_optional(func_bounds),
                    std::format("perturbation function ({:d})\n{}", func_bounds, display_enum(func_bounds)));
 
     termination_condition term;
-    static constexpr bounds_t<termination_condition> term_bounds{termination_condition::accuracy,
-                                                                 termination_condition::iterations};
     parser.add_arg("term", term, std::make_optional(term_bounds),
                    std::format("termination condition ({:d})\n{}", term_bounds, display_enum(term_bounds)));
 
-    static constexpr bounds_t<double> term_accuracy_bounds{1e-20, 1e-4};
-    static constexpr bounds_t<uint64_t> term_iteration_bounds{1, 200000};
-
     std::string acc_iter;
     parser.add_arg("acc/iter", acc_iter, std::optional<bounds_t<std::string>>{std::nullopt},
                    std::format("depending on term:\n"
@@ -187,9 +174,103 @@ namespace partdiff {
                                "{0}iterations:    {2:d}",
                                indent, term_accuracy_bounds, term_iteration_bounds));
 
+    simd_kernel kernel = simd_kernel::automatic;
+    parser.add_option("kernel", kernel, std::make_optional(kernel_bounds),
+                      std::format("Jacobi stencil kernel ({:d})\n{}", kernel_bounds, display_enum(kernel_bounds)));
+
+    uint64_t tile_depth = 0;
+    parser.add_option("tile", tile_depth, std::make_optional(tile_depth_bounds),
+                      std::format("Jacobi iterations per pass over the grid ({:d})\n"
+                                  "{}temporal tiling, only used with term = 2",
+                                  tile_depth_bounds, indent));
+
+    bool fused = false;
+    parser.add_option("fused", fused, std::optional<bounds_t<bool>>{std::nullopt},
+                      std::format("two Jacobi iterations per pass over a single matrix (0 .. 1)\n"
+                                  "{}with term = 1 only between the residuum checks",
+                                  indent));
+
+    bool huge_pages = false;
+    parser.add_option("hugepages", huge_pages, std::optional<bounds_t<bool>>{std::nullopt},
+                      std::string("back the matrices with transparent huge pages (0 .. 1)"));
+
+    storage_precision precision = storage_precision::double_precision;
+    parser.add_option("precision", precision, std::make_optional(precision_bounds),
+                      std::format("storage precision of the matrices ({:d})\n{}", precision_bounds,
+                                  display_enum(precision_bounds)));
+
+    double omega = 0.0;
+    parser.add_option("omega", omega, std::make_optional(omega_bounds),
+                      std::format("relaxation factor of SOR ({:g})\n"
+                                  "{}default 0: the optimal 2 / (1 + sin(pi * h))",
+                                  omega_bounds, indent));
+
+    std::string checkpoint_path;
+    parser.add_option("checkpoint", checkpoint_path, std::optional<bounds_t<std::string>>{std::nullopt},
+                      std::string("file to write checkpoints to"));
+
+    uint64_t checkpoint_every = 1000;
+    parser.add_option("ckpt-every", checkpoint_every, std::make_optional(checkpoint_every_bounds),
+                      std::format("iterations between checkpoints ({:d}, default: 1000)", checkpoint_every_bounds));
+
+    uint64_t check_every = 1;
+    parser.add_option("check-every", check_every, std::make_optional(check_every_bounds),
+                      std::format("most sweeps between residuum checks with term = 1 ({:d})\n"
+                                  "{}the checks get denser as the residuum approaches acc",
+                                  check_every_bounds, indent));
+
+    std::string trace_path;
+    parser.add_option("trace", trace_path, std::optional<bounds_t<std::string>>{std::nullopt},
+                      std::format("file to write a trace of the iterations to\n"
+                                  "{}CSV if it ends in .csv, binary otherwise",
+                                  indent));
+
+    uint64_t trace_every = 1;
+    parser.add_option("trace-every", trace_every, std::make_optional(trace_every_bounds),
+                      std::format("iterations between trace records ({:d}, default: 1)", trace_every_bounds));
+
+    uint64_t trace_size = 65536;
+    parser.add_option("trace-size", trace_size, std::make_optional(trace_size_bounds),
+                      std::format("trace records kept, the oldest are dropped ({:d}, default: 65536)",
+                                  trace_size_bounds));
+
+    bool perf = false;
+    parser.add_option("perf", perf, std::optional<bounds_t<bool>>{std::nullopt},
+                      std::format("count cycles, instructions, cache misses and stalls (0 .. 1)\n"
+                                  "{}with perf_event_open, per thread",
+                                  indent));
+
+    std::string field_path;
+    parser.add_option("field", field_path, std::optional<bounds_t<std::string>>{std::nullopt},
+                      std::format("file to write the whole solution to\n"
+                                  "{}in binary, see field_output.hpp",
+                                  indent));
+
+    bool nested = false;
+    parser.add_option("nested", nested, std::optional<bounds_t<bool>>{std::nullopt},
+                      std::format("start from the solution of ever coarser grids (0 .. 1)\n"
+                                  "{}only used with term = 1",
+                                  indent));
+
+    bool adaptive = false;
+    parser.add_option("adaptive", adaptive, std::optional<bounds_t<bool>>{std::nullopt},
+                      std::format("skip the blocks of the grid that have stopped changing (0 .. 1)\n"
+                                  "{}only used with term = 1 and methods 1, 2 and 6",
+                                  indent));
+
+    bool setup_time = false;
+    parser.add_option("setup-time", setup_time, std::optional<bounds_t<bool>>{std::nullopt},
+                      std::string("also print the time to allocate and initialize the matrices (0 .. 1)"));
+
+    std::string resume_path;
+    parser.add_option("resume", resume_path, std::optional<bounds_t<std::string>>{std::nullopt},
+                      std::format("checkpoint to resume from\n"
+                                  "{}its problem replaces method, lines and func",
+                                  indent));
+
     if (!parser.parse_args(args)) {
       parser.usage();
-      exit(EXIT_SUCCESS);
+      return std::nullopt;
     }
 
     uint64_t term_iteration;
@@ -200,22 +281,175 @@ namespace partdiff {
       accuracy_parser.add_arg("acc", term_accuracy, std::make_optional(term_accuracy_bounds), std::nullopt);
       if (!accuracy_parser.parse_arg(0, acc_iter)) {
         parser.usage();
-        exit(EXIT_SUCCESS);
+        return std::nullopt;
       }
+      // A run that can't reach the accuracy, e.g. with float storage, gives up after the most iterations.
       term_iteration = term_iteration_bounds.upper;
     } else {
       argument_parser iteration_parser(std::nullopt, std::nullopt);
       iteration_parser.add_arg("iter", term_iteration, std::make_optional(term_iteration_bounds), std::nullopt);
       if (!iteration_parser.parse_arg(0, acc_iter)) {
         parser.usage();
-        exit(EXIT_SUCCESS);
+        return std::nullopt;
       }
       term_accuracy = 0.0;
     }
-    const calculation_options options{number, lines, method, func, term, term_iteration, term_accuracy};
+    calculation_options options{.number = number,
+                                .interlines = lines,
+                                .method = method,
+                                .pert_func = func,
+                                .termination = term,
+                                .term_iteration = term_iteration,
+                                .term_accuracy = term_accuracy,
+                                .kernel = kernel,
+                                .tile_depth = tile_depth,
+                                .huge_pages = huge_pages,
+                                .precision = precision,
+                                .omega = omega,
+                                .checkpoint_path = checkpoint_path,
+                                .checkpoint_every = checkpoint_every,
+                                .resume_path = resume_path,
+                                .check_every = check_every,
+                                .trace_path = trace_path,
+                                .trace_every = trace_every,
+                                .trace_size = trace_size,
+                                .perf = perf,
+                                .field_path = field_path,
+                                .setup_time = setup_time,
+                                .nested = nested,
+                                .adaptive = adaptive,
+                                .fused = fused};
+    if (!resume_path.empty()) {
+      read_checkpoint_options(resume_path, options);
+    }
     return options;
   }
 
+#if !defined(PARTDIFF_MPI)
+
+  static calculation_options parse_args(const int argc, char const *argv[]) {
+    const std::optional<calculation_options> options =
+        parse_options(argv[0], std::vector<std::string>(argv + 1, argv + argc));
+    if (!options) {
+      exit(EXIT_SUCCESS);
+    }
+    return *options;
+  }
+
+  // Runs the jobs of a job file in one process. Every line holds the arguments of one partdiff run, empty lines and
+  // lines starting with # are skipped. The jobs are dealt out to a pool of workers, each of which still uses the
+  // number of threads given in its job, so by default there are only as many workers as the CPUs can run jobs with the
+  // most threads. Jobs of the same size take over the matrices of the ones before them.
+  // The output of every job is the same as that of a single run, and it is printed in the order of the job file.
+  static void run_batch(const int argc, char const *argv[]) {
+    const std::string app_name = argv[0];
+    const std::vector<std::string> args(argv + 1, argv + argc);
+    argument_parser parser(app_name, std::format("Example: {} --batch=jobs.txt --workers=4", app_name));
+
+    std::string job_path;
+    parser.add_option("batch", job_path, std::optional<bounds_t<std::string>>{std::nullopt},
+                      std::string("file with the arguments of one run per line"));
+
+    static constexpr bounds_t<uint64_t> workers_bounds{1, 1024};
+    // Zero until given, since the default depends on the jobs.
+    uint64_t num_workers = 0;
+    parser.add_option("workers", num_workers, std::make_optional(workers_bounds),
+                      std::format("number of jobs that run at the same time ({:d}, default: number of CPUs / most "
+                                  "threads of a job)",
+                                  workers_bounds));
+
+    if (!parser.parse_args(args) || job_path.empty()) {
+      parser.usage();
+      exit(EXIT_SUCCESS);
+    }
+
+    std::ifstream job_file(job_path);
+    if (!job_file) {
+      std::println("Batch failure! (Could not open {})", job_path);
+      exit(EXIT_FAILURE);
+    }
+    std::vector<calculation_options> jobs;
+    std::string line;
+    for (int line_number = 1; std::getline(job_file, line); line_number++) {
+      std::istringstream tokens(line);
+      const std::vector<std::string> job_args{std::istream_iterator<std::string>(tokens),
+                                              std::istream_iterator<std::string>()};
+      if (job_args.empty() || job_args[0].starts_with("#")) {
+        continue;
+      }
+      const std::optional<calculation_options> options = parse_options(app_name, job_args);
+      if (!options) {
+        std::println("Batch failure! (Invalid job in line {} of {})", line_number, job_path);
+        exit(EXIT_FAILURE);
+      }
+      jobs.push_back(*options);
+    }
+
+    if (num_workers == 0 && !jobs.empty()) {
+      const uint64_t max_threads =
+          std::ranges::max(jobs, {}, [](const calculation_options &options) { return options.number; }).number;
+      num_workers = std::clamp<uint64_t>(std::thread::hardware_concurrency() / max_threads, 1, workers_bounds.upper);
+    }
+
+    // Every worker can leave its matrices to the next job of the same size.
+    tensor_pool pool(num_workers);
+    std::vector<std::string> outputs(jobs.size());
+    std::vector<bool> finished(jobs.size(), false);
+    std::mutex mutex;
+    std::condition_variable job_finished;
+    std::atomic<std::size_t> next_job = 0;
+
+    const auto worker = [&]() {
+      for (std::size_t j = next_job++; j < jobs.size(); j = next_job++) {
+        const calculation_options &options = jobs[j];
+        calculation_arguments arguments(options, pool);
+        const calculation_results results = calculate(arguments, options);
+
+        char *buffer = nullptr;
+        std::size_t size = 0;
+        std::FILE *out = open_memstream(&buffer, &size);
+        if (out == nullptr) {
+          std::println("Batch failure! (Could not buffer the output of job {})", j + 1);
+          exit(EXIT_FAILURE);
+        }
+        display_statistics(arguments, results, options, out);
+        display_matrix(arguments.sample(results.m, options.interlines), out);
+        std::fclose(out);
+        if (!options.field_path.empty()) {
+          write_field(options.field_path, arguments, results, options);
+        }
+        arguments.release_matrices(pool);
+
+        {
+          std::lock_guard lock(mutex);
+          outputs[j].assign(buffer, size);
+          finished[j] = true;
+        }
+        std::free(buffer);
+        job_finished.notify_one();
+      }
+    };
+
+    std::vector<std::jthread> workers;
+    for (uint64_t w = 0; w < std::min<uint64_t>(num_workers, jobs.size()); w++) {
+      workers.emplace_back(worker);
+    }
+    for (std::size_t j = 0; j < jobs.size(); j++) {
+      std::string output;
+      {
+        std::unique_lock lock(mutex);
+        job_finished.wait(lock, [&]() { return finished[j]; });
+        output = std::move(outputs[j]);
+      }
+      if (j > 0) {
+        std::println("");
+      }
+      std::print("{}", output);
+    }
+  }
+
+#endif
+
 } // namespace partdiff
 
 using calculation_arguments = partdiff::calculation_arguments;
@@ -223,14 +457,76 @@ using calculation_results = partdiff::calculation_results;
 using argument_parser = partdiff::argument_parser;
 using calculation_options = partdiff::calculation_options;
 
+#if defined(PARTDIFF_MPI)
+
+// partdiff-mpi splits the rows among the ranks, and rank 0 displays the results.
+int main(int argc, char *argv[]) {
+  MPI_Init(&argc, &argv);
+  int rank;
+  int num_ranks;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &num_ranks);
+
+  // Every rank parses the same arguments, so on invalid ones they all finalize MPI before they leave. Reading the
+  // checkpoint to resume from may fail as well, which mpi_supported() would reject anyway.
+  std::optional<calculation_options> parsed;
+  try {
+    const partdiff::failure_guard guard;
+    parsed = partdiff::parse_options(argv[0], std::vector<std::string>(argv + 1, argv + argc));
+  } catch (const partdiff::calculation_failure &failure) {
+    if (rank == 0) {
+      std::println("{}", failure.what());
+    }
+    MPI_Finalize();
+    return EXIT_FAILURE;
+  }
+  if (!parsed) {
+    MPI_Finalize();
+    return EXIT_SUCCESS;
+  }
+  const calculation_options options = *parsed;
+  if (!partdiff::mpi_supported(options, rank, num_ranks)) {
+    MPI_Finalize();
+    return EXIT_FAILURE;
+  }
+  calculation_arguments arguments(options, rank, num_ranks);
+
+  calculation_results results = partdiff::calculate_mpi(arguments, options);
+  const partdiff::matrix_sample sample = partdiff::gather_sample(arguments, results, options);
+  if (!options.field_path.empty()) {
+    partdiff::write_field(options.field_path, arguments, results, options);
+  }
+
+  if (rank == 0) {
+    partdiff::display_statistics(arguments, results, options);
+    partdiff::display_matrix(sample);
+  }
+
+  MPI_Finalize();
+  return EXIT_SUCCESS;
+}
+
+#else
+
 int main(const int argc, char const *argv[]) {
+  if (argc > 1 && std::string_view(argv[1]).starts_with("--batch")) {
+    partdiff::run_batch(argc, argv);
+    return EXIT_SUCCESS;
+  }
+
   calculation_options options = partdiff::parse_args(argc, argv);
   calculation_arguments arguments(options);
 
   calculation_results results = partdiff::calculate(arguments, options);
 
   partdiff::display_statistics(arguments, results, options);
-  partdiff::display_matrix(arguments, results, options);
+  partdiff::display_matrix(arguments.sample(results.m, options.interlines));
+
+  if (!options.field_path.empty()) {
+    partdiff::write_field(options.field_path, arguments, results, options);
+  }
 
   return EXIT_SUCCESS;
 }
+
+#endif
@@ -0,0 +1,89 @@
+#include "perf_counters.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace partdiff {
+
+  static constexpr std::array<std::pair<uint32_t, uint64_t>, 5> perf_event_configs = {{
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+      {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                               (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND},
+  }};
+
+  perf_sample &perf_sample::operator+=(const perf_sample &other) {
+    for (std::size_t e = 0; e < this->counts.size(); e++) {
+      if (this->counts[e] && other.counts[e]) {
+        *this->counts[e] += *other.counts[e];
+      } else {
+        this->counts[e].reset();
+      }
+    }
+    return *this;
+  }
+
+  perf_counters::perf_counters() {
+    int first_errno = 0;
+    for (std::size_t e = 0; e < this->fds.size(); e++) {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = perf_event_configs[e].first;
+      attr.config = perf_event_configs[e].second;
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      this->fds[e] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+      if (this->fds[e] < 0 && first_errno == 0) {
+        first_errno = errno;
+      }
+    }
+    if (std::all_of(this->fds.begin(), this->fds.end(), [](const int fd) { return fd < 0; })) {
+      this->open_error = std::format("perf_event_open: {}", std::strerror(first_errno));
+    }
+  }
+
+  perf_counters::~perf_counters() {
+    for (const int fd : this->fds) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+  }
+
+  void perf_counters::start() {
+    for (const int fd : this->fds) {
+      if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+  }
+
+  perf_sample perf_counters::stop() {
+    perf_sample sample;
+    for (std::size_t e = 0; e < this->fds.size(); e++) {
+      if (this->fds[e] < 0) {
+        continue;
+      }
+      ioctl(this->fds[e], PERF_EVENT_IOC_DISABLE, 0);
+      // The value, the time enabled and the time running.
+      uint64_t values[3];
+      if (read(this->fds[e], values, sizeof(values)) != sizeof(values) || values[2] == 0) {
+        continue;
+      }
+      sample.counts[e] = (values[2] < values[1]) ? (uint64_t)((double)values[0] * values[1] / values[2]) : values[0];
+    }
+    return sample;
+  }
+
+} // namespace partdiff
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace partdiff {
+
+  enum class perf_event { cycles, instructions, l1d_misses, llc_misses, backend_stalls };
+
+  // The counts of one thread. An event that the CPU or the kernel doesn't allow to count is missing.
+  struct perf_sample {
+    std::array<std::optional<uint64_t>, 5> counts;
+
+    std::optional<uint64_t> operator[](perf_event event) const {
+      return this->counts[static_cast<std::size_t>(event)];
+    }
+    perf_sample &operator+=(const perf_sample &other);
+  };
+
+  // Counts hardware events of the calling thread in user space with perf_event_open(2). Every event is opened on its
+  // own, so that the counters the CPU lacks (backend stalls are missing on many Intel CPUs) or that perf_event_paranoid
+  // forbids only leave a gap instead of disabling all of them. If the kernel had to multiplex the counters, the counts
+  // are scaled up to the whole time that they were enabled.
+  class perf_counters {
+    public:
+    perf_counters();
+    ~perf_counters();
+    perf_counters(const perf_counters &) = delete;
+    perf_counters &operator=(const perf_counters &) = delete;
+    void start();
+    perf_sample stop();
+    // The reason why no event could be opened, e.g. because the counters are not permitted.
+    std::optional<std::string> error() const {
+      return this->open_error;
+    }
+
+    private:
+    std::array<int, 5> fds;
+    std::optional<std::string> open_error;
+  };
+
+} // namespace partdiff
@@ -0,0 +1,24 @@
+#include "perturbation_source.hpp"
+#include <cmath>
+#include <numbers>
+
+namespace partdiff {
+
+  static constexpr double pi = std::numbers::pi;
+  static constexpr double two_pi_square = (2 * pi * pi);
+
+  perturbation_source::perturbation_source(perturbation_function pert_func, uint64_t N, double h) {
+    if (pert_func != perturbation_function::fpisin) {
+      return;
+    }
+    const double pih = pi * h;
+    const double fpisin = 0.25 * two_pi_square * h * h;
+    this->row_factors.resize(N + 1);
+    this->col_factors.resize(N + 1);
+    for (uint64_t k = 0; k <= N; k++) {
+      this->col_factors[k] = std::sin(pih * (double)k);
+      this->row_factors[k] = fpisin * this->col_factors[k];
+    }
+  }
+
+} // namespace partdiff
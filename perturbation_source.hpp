@@ -0,0 +1,27 @@
+#pragma once
+
+#include "enums.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace partdiff {
+
+  // The perturbation function 2 * pi^2 * sin(pi * x) * sin(pi * y) is separable, so instead of evaluating sin() at
+  // every grid point in every sweep, the factors of each row and each column are computed once. A kernel then adds
+  // row_factors[i] * col_factors[j], which is exactly the value it used to compute on the fly.
+  struct perturbation_source {
+
+    // fpisin * sin(pi * h * i), where fpisin = 0.25 * 2 * pi^2 * h^2
+    std::vector<double> row_factors;
+    // sin(pi * h * j)
+    std::vector<double> col_factors;
+
+    perturbation_source() {};
+    perturbation_source(perturbation_function pert_func, uint64_t N, double h);
+
+    bool enabled() const {
+      return !row_factors.empty();
+    }
+  };
+
+} // namespace partdiff
@@ -0,0 +1,15 @@
+#include "solve_control.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace partdiff {
+
+  solve_control::solve_control(const uint64_t progress_every, progress_callback on_progress)
+    : progress_every(std::max<uint64_t>(progress_every, 1)),
+      on_progress(std::move(on_progress)) {}
+
+  void solve_control::report(const uint64_t iteration, const double residuum) const {
+    this->on_progress(iteration, residuum);
+  }
+
+} // namespace partdiff
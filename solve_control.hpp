@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+namespace partdiff {
+
+  // Lets the caller of calculate() watch and stop a calculation that runs on other threads. Every progress_every-th
+  // iteration computes the residuum and hands it to the progress callback, which runs on one of the solver threads
+  // while the others wait for it, so it must be short and must not throw. cancel() may be called from any thread; the
+  // calculation then stops after the current sweep and returns the iterations done so far. With --nested, the coarser
+  // grids report their iterations first, each grid counting from 0 again.
+  class solve_control {
+    public:
+    using progress_callback = std::function<void(uint64_t iteration, double residuum)>;
+
+    solve_control() = default;
+    solve_control(uint64_t progress_every, progress_callback on_progress);
+    solve_control(const solve_control &) = delete;
+    solve_control &operator=(const solve_control &) = delete;
+
+    void cancel() {
+      this->cancel_requested.store(true, std::memory_order_relaxed);
+    }
+    bool cancelled() const {
+      return this->cancel_requested.load(std::memory_order_relaxed);
+    }
+    // Whether one of the num_iterations iterations after stat_iteration reports its progress.
+    bool due(uint64_t stat_iteration, uint64_t num_iterations = 1) const {
+      return this->on_progress &&
+             (stat_iteration + num_iterations) / this->progress_every > stat_iteration / this->progress_every;
+    }
+    // Reports the residuum after iteration, which is NaN if the sweep didn't compute it.
+    void report(uint64_t iteration, double residuum) const;
+
+    private:
+    uint64_t progress_every = 1;
+    progress_callback on_progress;
+    std::atomic<bool> cancel_requested = false;
+  };
+
+} // namespace partdiff
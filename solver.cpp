@@ -0,0 +1,152 @@
+#include "solver.hpp"
+#include "calculation.hpp"
+#include "checkpoint.hpp"
+#include "field_output.hpp"
+#include "option_bounds.hpp"
+#include <format>
+#include <string_view>
+#include <utility>
+
+namespace partdiff {
+
+  namespace {
+
+    template <typename T>
+    void check_bounds(const std::string_view name, const T value, const bounds_t<T> &bounds) {
+      if (!bounds.contains(value)) {
+        fail(std::format("Options failure! ({} is out of range)", name));
+      }
+    }
+
+    // The checks of partdiff's argument parser, and a checkpoint to resume from has to hold the problem of options,
+    // which partdiff would take from it instead.
+    void check_options(const calculation_options &options) {
+      check_bounds("number", options.number, num_bounds);
+      check_bounds("method", options.method, method_bounds);
+      check_bounds("interlines", options.interlines, lines_bounds);
+      check_bounds("pert_func", options.pert_func, func_bounds);
+      check_bounds("termination", options.termination, term_bounds);
+      if (options.termination == termination_condition::accuracy) {
+        check_bounds("term_accuracy", options.term_accuracy, term_accuracy_bounds);
+      }
+      check_bounds("term_iteration", options.term_iteration, term_iteration_bounds);
+      check_bounds("kernel", options.kernel, kernel_bounds);
+      check_bounds("tile_depth", options.tile_depth, tile_depth_bounds);
+      check_bounds("precision", options.precision, precision_bounds);
+      check_bounds("omega", options.omega, omega_bounds);
+      check_bounds("checkpoint_every", options.checkpoint_every, checkpoint_every_bounds);
+      check_bounds("check_every", options.check_every, check_every_bounds);
+      check_bounds("trace_every", options.trace_every, trace_every_bounds);
+      check_bounds("trace_size", options.trace_size, trace_size_bounds);
+
+      if (!options.resume_path.empty()) {
+        calculation_options stored = options;
+        read_checkpoint_options(options.resume_path, stored);
+        if (stored.interlines != options.interlines || stored.method != options.method ||
+            stored.pert_func != options.pert_func || stored.precision != options.precision) {
+          fail(std::format("Checkpoint failure! ({} holds a different problem)", options.resume_path));
+        }
+      }
+    }
+
+  } // namespace
+
+  solve_handle::shared_state::shared_state(const uint64_t progress_every, solve_control::progress_callback on_progress)
+    : control(progress_every, std::move(on_progress)) {}
+
+  solve_handle::solve_handle(std::shared_ptr<shared_state> state)
+    : state(std::move(state)) {}
+
+  solve_handle::~solve_handle() {
+    if (!this->state) {
+      return;
+    }
+    this->state->control.cancel();
+    // A coroutine that was resumed on the calculation's thread may drop the handle there, and the thread can't join
+    // itself. It has finished the calculation by then and only holds on to the state until it returns.
+    if (this->thread.joinable() && this->thread.get_id() == std::this_thread::get_id()) {
+      this->thread.detach();
+    }
+  }
+
+  bool solve_handle::ready() const {
+    std::lock_guard lock(this->state->mutex);
+    return this->state->done();
+  }
+
+  void solve_handle::cancel() {
+    this->state->control.cancel();
+  }
+
+  bool solve_handle::cancelled() const {
+    return this->state->control.cancelled();
+  }
+
+  void solve_handle::wait() const {
+    std::unique_lock lock(this->state->mutex);
+    this->state->finished.wait(lock, [&]() { return this->state->done(); });
+  }
+
+  const calculation_results &solve_handle::result() const {
+    this->wait();
+    if (this->state->error) {
+      std::rethrow_exception(this->state->error);
+    }
+    return *this->state->results;
+  }
+
+  calculation_arguments &solve_handle::arguments() const {
+    this->wait();
+    if (this->state->error) {
+      std::rethrow_exception(this->state->error);
+    }
+    return *this->state->arguments;
+  }
+
+  bool solve_handle::await_suspend(const std::coroutine_handle<> continuation) const {
+    std::lock_guard lock(this->state->mutex);
+    if (this->state->done()) {
+      return false;
+    }
+    this->state->continuations.push_back(continuation);
+    return true;
+  }
+
+  solve_handle solve_async(const calculation_options &options, const uint64_t progress_every,
+                           solve_control::progress_callback on_progress) {
+    auto state = std::make_shared<solve_handle::shared_state>(progress_every, std::move(on_progress));
+    solve_handle handle(state);
+    handle.thread = std::jthread([state, options]() {
+      // The matrices are set up on this thread as well, so that starting many calculations doesn't block the caller.
+      // Whatever goes wrong ends up in the handle instead of ending the process.
+      std::optional<calculation_results> results;
+      std::exception_ptr error;
+      try {
+        const failure_guard guard;
+        check_options(options);
+        state->arguments.emplace(options);
+        state->arguments->control = &state->control;
+        results = calculate(*state->arguments, options);
+        if (!options.field_path.empty()) {
+          write_field(options.field_path, *state->arguments, *results, options);
+        }
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      std::vector<std::coroutine_handle<>> continuations;
+      {
+        std::lock_guard lock(state->mutex);
+        state->results = std::move(results);
+        state->error = error;
+        continuations.swap(state->continuations);
+      }
+      state->finished.notify_all();
+      for (const auto continuation : continuations) {
+        continuation.resume();
+      }
+    });
+    return handle;
+  }
+
+} // namespace partdiff
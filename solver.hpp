@@ -0,0 +1,88 @@
+#pragma once
+
+#include "calculation_arguments.hpp"
+#include "calculation_options.hpp"
+#include "calculation_results.hpp"
+#include "failure.hpp"
+#include "solve_control.hpp"
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace partdiff {
+
+  // The entry point of libpartdiff for programs that run many calculations in one process. solve_async() sets up the
+  // matrices and runs calculate() on a thread of its own, which in turn starts options.number - 1 worker threads, and
+  // returns at once. The handle polls, waits for or co_awaits the result, and cancels the calculation between sweeps.
+  // Destroying the handle cancels the calculation and waits for its threads to finish.
+  //
+  //   partdiff::solve_handle handle = partdiff::solve_async(options, 100, [](uint64_t iteration, double residuum) {
+  //     std::println("{}: {}", iteration, residuum);
+  //   });
+  //   const partdiff::calculation_results &results = co_await handle;
+  //
+  // The options have to be within the bounds of partdiff's arguments, and a checkpoint to resume from has to hold the
+  // same problem. With a field_path, the solution goes to that file once the calculation has finished. If the
+  // calculation can't run, e.g. because an option is out of range, the matrices can't be allocated or a file can't be
+  // read or written, result(), arguments() and co_await throw a calculation_failure with a message like those of
+  // partdiff. The other calculations in the process are not affected.
+  class solve_handle {
+    public:
+    solve_handle(solve_handle &&) = default;
+    solve_handle &operator=(solve_handle &&) = delete;
+    ~solve_handle();
+
+    // Whether the calculation has finished or failed, after which result() and arguments() don't block.
+    bool ready() const;
+    // Asks the calculation to stop after the current sweep. The result holds the iterations done until then.
+    void cancel();
+    bool cancelled() const;
+    // Blocks until the calculation has finished or failed.
+    void wait() const;
+    const calculation_results &result() const;
+    // The matrices and the grid of the calculation, e.g. for arguments().sample(result().m, interlines).
+    calculation_arguments &arguments() const;
+
+    // co_await resumes the awaiting coroutine on the calculation's thread once it has finished, or right away if it
+    // already has.
+    bool await_ready() const {
+      return this->ready();
+    }
+    bool await_suspend(std::coroutine_handle<> continuation) const;
+    const calculation_results &await_resume() const {
+      return this->result();
+    }
+
+    private:
+    struct shared_state {
+      solve_control control;
+      std::optional<calculation_arguments> arguments;
+      std::optional<calculation_results> results;
+      std::exception_ptr error;
+      mutable std::mutex mutex;
+      mutable std::condition_variable finished;
+      std::vector<std::coroutine_handle<>> continuations;
+      shared_state(uint64_t progress_every, solve_control::progress_callback on_progress);
+      bool done() const {
+        return this->results || this->error;
+      }
+    };
+    std::shared_ptr<shared_state> state;
+    std::jthread thread;
+
+    explicit solve_handle(std::shared_ptr<shared_state> state);
+    friend solve_handle solve_async(const calculation_options &, uint64_t, solve_control::progress_callback);
+  };
+
+  // Starts a calculation in the background. Unless on_progress is empty, it receives the iteration count and the
+  // residuum of every progress_every-th iteration, see solve_control.
+  solve_handle solve_async(const calculation_options &options, uint64_t progress_every = 1,
+                           solve_control::progress_callback on_progress = {});
+
+} // namespace partdiff
@@ -1,61 +1,146 @@
 #include "tensor.hpp"
-#include <print>
+#include "failure.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <sys/mman.h>
 #include <utility>
 
 namespace partdiff {
 
-  tensor::tensor(std::size_t num_matrices, std::size_t num_rows, std::size_t num_cols)
+  static constexpr std::size_t cache_line_size = 64;
+  static constexpr std::size_t page_size = 4096;
+  static constexpr std::size_t huge_page_size = 2 * 1024 * 1024;
+
+  static std::size_t round_up(std::size_t value, std::size_t multiple) {
+    return ((value + multiple - 1) / multiple) * multiple;
+  }
+
+  template <typename T>
+  basic_tensor<T>::basic_tensor(std::size_t num_matrices, std::size_t num_rows, std::size_t num_cols, bool huge_pages,
+                                std::size_t first_row)
+    : num_matrices(num_matrices),
+      num_rows(num_rows),
+      num_cols(num_cols),
+      row_stride(round_up(num_cols, cache_line_size / sizeof(T))),
+      matrix_stride(row_stride * num_rows),
+      first_row(first_row) {
+    const auto alignment = huge_pages ? huge_page_size : page_size;
+    const auto size_bytes = round_up(num_matrices * matrix_stride * sizeof(T), alignment);
+    // mmap only aligns to pages, so map enough to cut a huge page aligned block out of the mapping.
+    const auto extra_bytes = alignment - page_size;
+    void *mapping = mmap(nullptr, size_bytes + extra_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+      fail(std::format("Memory failure! (Requested {} bytes)", size_bytes));
+    }
+    const auto begin = reinterpret_cast<std::uintptr_t>(mapping);
+    const auto aligned = round_up(begin, alignment);
+    if (aligned > begin) {
+      munmap(mapping, aligned - begin);
+    }
+    if (begin + extra_bytes > aligned) {
+      munmap(reinterpret_cast<void *>(aligned + size_bytes), begin + extra_bytes - aligned);
+    }
+    data = reinterpret_cast<T *>(aligned);
+    mapped_bytes = size_bytes;
+#if defined(MADV_HUGEPAGE)
+    if (huge_pages) {
+      // This is only advice, so it doesn't matter if the kernel declines it.
+      madvise(data, size_bytes, MADV_HUGEPAGE);
+    }
+#endif
+  }
+
+  template <typename T>
+  basic_tensor<T>::basic_tensor(int fd, std::size_t offset, std::size_t num_matrices, std::size_t num_rows,
+                                std::size_t num_cols)
     : num_matrices(num_matrices),
       num_rows(num_rows),
-      num_cols(num_cols) {
-    auto size = num_matrices * num_rows * num_cols;
-    try {
-      data = new double[size];
-    } catch (std::bad_alloc &) {
-      auto size_bytes = size * sizeof(double);
-      std::println("Memory failure! (Requested {} bytes)", size_bytes);
-      exit(EXIT_FAILURE);
+      num_cols(num_cols),
+      row_stride(round_up(num_cols, cache_line_size / sizeof(T))),
+      matrix_stride(row_stride * num_rows),
+      mapped_bytes(num_matrices * matrix_stride * sizeof(T)) {
+    void *mapping = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, offset);
+    if (mapping == MAP_FAILED) {
+      fail(std::format("Memory failure! (Could not map {} bytes)", mapped_bytes));
     }
+    data = static_cast<T *>(mapping);
   }
 
-  tensor::tensor(const tensor &other)
+  template <typename T>
+  basic_tensor<T>::basic_tensor(const basic_tensor &other)
     : num_matrices(other.num_matrices),
       num_rows(other.num_rows),
       num_cols(other.num_cols),
+      row_stride(other.row_stride),
+      matrix_stride(other.matrix_stride),
+      first_row(other.first_row),
       data(other.data) {}
 
-  tensor::tensor(tensor &&other) noexcept
+  template <typename T>
+  basic_tensor<T>::basic_tensor(basic_tensor &&other) noexcept
     : num_matrices(other.num_matrices),
       num_rows(other.num_rows),
       num_cols(other.num_cols),
-      data(std::exchange(other.data, nullptr)) {}
+      row_stride(other.row_stride),
+      matrix_stride(other.matrix_stride),
+      first_row(other.first_row),
+      data(std::exchange(other.data, nullptr)),
+      mapped_bytes(std::exchange(other.mapped_bytes, 0)) {}
 
-  tensor &tensor::operator=(const tensor &other) {
-    return *this = tensor(other);
+  template <typename T>
+  basic_tensor<T> &basic_tensor<T>::operator=(const basic_tensor &other) {
+    return *this = basic_tensor(other);
   }
 
-  tensor &tensor::operator=(tensor &&other) noexcept // move assignment
+  template <typename T>
+  basic_tensor<T> &basic_tensor<T>::operator=(basic_tensor &&other) noexcept // move assignment
   {
     std::swap(data, other.data);
+    std::swap(mapped_bytes, other.mapped_bytes);
     num_matrices = other.num_matrices;
     num_cols = other.num_cols;
     num_rows = other.num_rows;
+    row_stride = other.row_stride;
+    matrix_stride = other.matrix_stride;
+    first_row = other.first_row;
     return *this;
   }
 
-  tensor::~tensor() {
-    if (data) {
-      delete[] data;
+  template <typename T>
+  basic_tensor<T>::~basic_tensor() {
+    if (data && mapped_bytes) {
+      munmap(data, mapped_bytes);
       data = nullptr;
     }
   }
 
-  double &tensor::operator[](std::size_t matrix, std::size_t row, std::size_t col) {
-    return data[(num_cols * num_rows * matrix) + (num_cols * row) + (col)];
+  template <typename T>
+  T &basic_tensor<T>::operator[](std::size_t matrix, std::size_t row, std::size_t col) {
+    return data[(matrix_stride * matrix) + (row_stride * (row - first_row)) + (col)];
   }
 
-  double tensor::operator[](std::size_t matrix, std::size_t row, std::size_t col) const {
-    return data[(num_cols * num_rows * matrix) + (num_cols * row) + (col)];
+  template <typename T>
+  T basic_tensor<T>::operator[](std::size_t matrix, std::size_t row, std::size_t col) const {
+    return data[(matrix_stride * matrix) + (row_stride * (row - first_row)) + (col)];
   }
 
+  template <typename T>
+  T *basic_tensor<T>::row(std::size_t matrix, std::size_t row) {
+    return &data[(matrix_stride * matrix) + (row_stride * (row - first_row))];
+  }
+
+  template <typename T>
+  const T *basic_tensor<T>::row(std::size_t matrix, std::size_t row) const {
+    return &data[(matrix_stride * matrix) + (row_stride * (row - first_row))];
+  }
+
+  template <typename T>
+  std::span<const T> basic_tensor<T>::elements() const {
+    return {data, num_matrices * matrix_stride};
+  }
+
+  template class basic_tensor<double>;
+  template class basic_tensor<float>;
+
 } // namespace partdiff
@@ -1,24 +1,46 @@
 #pragma once
 
 #include <cstddef>
+#include <span>
 
 namespace partdiff {
 
-  class tensor {
+  // Every row starts on a cache line and the whole block is page aligned (or huge page aligned and advised as such
+  // with huge_pages). The memory is an anonymous mapping, so a new tensor is all zeros without being filled, and its
+  // pages are not touched on allocation, so that the threads that will work on it can touch them first and the pages
+  // end up on their NUMA node.
+  // T is the storage type of the elements. It is instantiated for double and float in tensor.cpp.
+  // A tensor may hold only the rows [first_row, first_row + num_rows) of a larger grid, e.g. the slab of one MPI rank.
+  // The rows are still addressed by their index in the whole grid.
+  template <typename T>
+  class basic_tensor {
     public:
-    tensor() {};
-    tensor(std::size_t num_matrices, std::size_t num_rows, std::size_t num_cols);
-    tensor(const tensor &other);
-    tensor(tensor &&other) noexcept;
-    tensor &operator=(const tensor &other);
-    tensor &operator=(tensor &&other) noexcept;
-    ~tensor();
-    double &operator[](std::size_t matrix, std::size_t row, std::size_t col);
-    double operator[](std::size_t matrix, std::size_t row, std::size_t col) const;
+    basic_tensor() {};
+    basic_tensor(std::size_t num_matrices, std::size_t num_rows, std::size_t num_cols, bool huge_pages = false,
+                 std::size_t first_row = 0);
+    // Maps the elements from the file fd, starting at the page aligned offset, instead of allocating them. The mapping
+    // is private, so changes to the tensor are not written back to the file.
+    basic_tensor(int fd, std::size_t offset, std::size_t num_matrices, std::size_t num_rows, std::size_t num_cols);
+    basic_tensor(const basic_tensor &other);
+    basic_tensor(basic_tensor &&other) noexcept;
+    basic_tensor &operator=(const basic_tensor &other);
+    basic_tensor &operator=(basic_tensor &&other) noexcept;
+    ~basic_tensor();
+    T &operator[](std::size_t matrix, std::size_t row, std::size_t col);
+    T operator[](std::size_t matrix, std::size_t row, std::size_t col) const;
+    T *row(std::size_t matrix, std::size_t row);
+    const T *row(std::size_t matrix, std::size_t row) const;
+    // All elements including the row padding, in memory order.
+    std::span<const T> elements() const;
 
     private:
     std::size_t num_matrices, num_rows, num_cols;
-    double *data = nullptr;
+    std::size_t row_stride, matrix_stride;
+    std::size_t first_row = 0;
+    T *data = nullptr;
+    std::size_t mapped_bytes = 0;
   };
 
+  using tensor = basic_tensor<double>;
+
 } // namespace partdiff
@@ -0,0 +1,44 @@
+#include "tensor_pool.hpp"
+#include <algorithm>
+
+namespace partdiff {
+
+  tensor_pool::tensor_pool(const std::size_t max_tensors)
+    : max_tensors(max_tensors) {}
+
+  template <typename T>
+  std::optional<basic_tensor<T>> tensor_pool::acquire(const shape &s) {
+    std::lock_guard lock(this->mutex);
+    const auto match = std::find_if(this->tensors.begin(), this->tensors.end(), [&s](const auto &entry) {
+      return entry.first == s && std::holds_alternative<basic_tensor<T>>(entry.second);
+    });
+    if (match == this->tensors.end()) {
+      return std::nullopt;
+    }
+    std::optional<basic_tensor<T>> t(std::move(std::get<basic_tensor<T>>(match->second)));
+    this->tensors.erase(match);
+    return t;
+  }
+
+  template <typename T>
+  void tensor_pool::release(const shape &s, basic_tensor<T> &&t) {
+    // Declared before the lock, so that the evicted tensor is unmapped after the lock is released.
+    pooled_tensor evicted;
+    std::lock_guard lock(this->mutex);
+    if (this->max_tensors == 0) {
+      evicted = std::move(t);
+      return;
+    }
+    if (this->tensors.size() == this->max_tensors) {
+      evicted = std::move(this->tensors.front().second);
+      this->tensors.erase(this->tensors.begin());
+    }
+    this->tensors.emplace_back(s, std::move(t));
+  }
+
+  template std::optional<basic_tensor<double>> tensor_pool::acquire(const shape &);
+  template std::optional<basic_tensor<float>> tensor_pool::acquire(const shape &);
+  template void tensor_pool::release(const shape &, basic_tensor<double> &&);
+  template void tensor_pool::release(const shape &, basic_tensor<float> &&);
+
+} // namespace partdiff
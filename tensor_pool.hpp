@@ -0,0 +1,39 @@
+#pragma once
+
+#include "tensor.hpp"
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace partdiff {
+
+  // Keeps the tensors of finished calculations, so that the next calculation with the same shape can take one over
+  // instead of allocating and faulting in fresh memory. The contents of a reused tensor are whatever the previous
+  // calculation left behind, so unlike a new one it has to be filled again. Several threads may share a pool.
+  // The pool holds at most max_tensors tensors. Releasing one more unmaps the one released longest ago, so that a run
+  // through many shapes doesn't keep every shape it has seen.
+  class tensor_pool {
+    public:
+    // The number of matrices, rows and columns, the first row and whether the tensor is backed by huge pages.
+    using shape = std::array<std::size_t, 5>;
+
+    explicit tensor_pool(std::size_t max_tensors);
+    // Takes a tensor of the shape out of the pool, or returns nothing if there is none.
+    template <typename T>
+    std::optional<basic_tensor<T>> acquire(const shape &s);
+    template <typename T>
+    void release(const shape &s, basic_tensor<T> &&t);
+
+    private:
+    using pooled_tensor = std::variant<basic_tensor<double>, basic_tensor<float>>;
+    const std::size_t max_tensors;
+    std::mutex mutex;
+    // In the order of their release.
+    std::vector<std::pair<shape, pooled_tensor>> tensors;
+  };
+
+} // namespace partdiff
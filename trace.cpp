@@ -0,0 +1,66 @@
+#include "trace.hpp"
+#include "failure.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <print>
+
+namespace partdiff {
+
+  static constexpr char trace_magic[8] = {'P', 'D', 'I', 'F', 'F', 'T', 'R', '1'};
+
+  trace_buffer::trace_buffer(const calculation_options &options)
+    : trace_every(std::max<uint64_t>(options.trace_every, 1)) {
+    if (!options.trace_path.empty()) {
+      this->records.resize(std::max<uint64_t>(options.trace_size, 1));
+    }
+  }
+
+  void trace_buffer::record(const uint64_t iteration, const double seconds, const double residuum,
+                            const std::span<const double> thread_seconds) {
+    trace_record &r = this->records[this->num_recorded % this->records.size()];
+    r = {iteration, seconds, residuum, 0.0, 0.0, 0, static_cast<uint32_t>(thread_seconds.size())};
+    for (std::size_t t = 0; t < thread_seconds.size(); t++) {
+      if (thread_seconds[t] > r.max_thread_seconds) {
+        r.max_thread_seconds = thread_seconds[t];
+        r.slowest_thread = static_cast<uint32_t>(t);
+      }
+      r.mean_thread_seconds += thread_seconds[t] / thread_seconds.size();
+    }
+    this->num_recorded++;
+  }
+
+  void trace_buffer::write(const std::string &path) const {
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if (!file) {
+      fail(std::format("Trace failure! (Could not open {})", path));
+    }
+
+    const uint64_t num_records = std::min<uint64_t>(this->num_recorded, this->records.size());
+    const uint64_t first = this->num_recorded - num_records;
+    const bool csv = path.ends_with(".csv");
+    bool ok = true;
+    if (csv) {
+      std::println(file, "iteration,seconds,residuum,max_thread_seconds,mean_thread_seconds,slowest_thread,threads");
+    } else {
+      trace_header header = {{}, sizeof(trace_record), num_records};
+      std::memcpy(header.magic, trace_magic, sizeof(trace_magic));
+      ok &= std::fwrite(&header, sizeof(header), 1, file) == 1;
+    }
+    for (uint64_t k = first; k < this->num_recorded; k++) {
+      const trace_record &r = this->records[k % this->records.size()];
+      if (csv) {
+        std::println(file, "{},{:e},{:e},{:e},{:e},{},{}", r.iteration, r.seconds, r.residuum, r.max_thread_seconds,
+                     r.mean_thread_seconds, r.slowest_thread, r.num_threads);
+      } else {
+        ok &= std::fwrite(&r, sizeof(r), 1, file) == 1;
+      }
+    }
+    ok &= std::fclose(file) == 0;
+    if (!ok) {
+      fail(std::format("Trace failure! (Could not write {})", path));
+    }
+  }
+
+} // namespace partdiff
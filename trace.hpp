@@ -0,0 +1,55 @@
+#pragma once
+
+#include "calculation_options.hpp"
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace partdiff {
+
+  // One traced iteration, or one pass of a tiled run, in which case iteration is the last iteration of the pass.
+  // The times are in seconds. Sweeps that don't compute the residuum record NaN as their residuum.
+  struct trace_record {
+    uint64_t iteration;
+    double seconds;
+    double residuum;
+    // The time from the start of the sweep until the slowest and an average thread were done with their part.
+    double max_thread_seconds;
+    double mean_thread_seconds;
+    uint32_t slowest_thread;
+    uint32_t num_threads;
+  };
+
+  struct trace_header {
+    char magic[8];
+    uint64_t record_size;
+    uint64_t num_records;
+  };
+
+  // Collects trace records of every trace_every-th iteration in a ring buffer that is allocated up front, so that
+  // recording costs a few clock reads and stores and never touches the file system. Once the buffer is full, the
+  // oldest records are overwritten. write() stores the records after the run: as CSV if the path ends in .csv, and
+  // otherwise as a trace_header with the magic "PDIFFTR1", followed by the trace_record structs in native byte order.
+  class trace_buffer {
+    public:
+    explicit trace_buffer(const calculation_options &options);
+    bool enabled() const {
+      return !this->records.empty();
+    }
+    // Whether one of the num_iterations iterations after stat_iteration is traced.
+    bool due(uint64_t stat_iteration, uint64_t num_iterations = 1) const {
+      return this->enabled() &&
+             (stat_iteration + num_iterations) / this->trace_every > stat_iteration / this->trace_every;
+    }
+    // Records an iteration from the sweep times of the threads.
+    void record(uint64_t iteration, double seconds, double residuum, std::span<const double> thread_seconds);
+    void write(const std::string &path) const;
+
+    private:
+    std::vector<trace_record> records;
+    uint64_t trace_every;
+    uint64_t num_recorded = 0;
+  };
+
+} // namespace partdiff